@@ -0,0 +1,230 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+/*
+ * Runs a suite of configurations through the console code paths and reports their throughput.
+ *
+ * Usage: scgms-console-bench [suite_path [repeat_count]]
+ *
+ * Each suite line is a console command line, i.e.; configuration_path [options], e.g.:
+ *   generator_metric.ini --execute
+ *   generator_metric.ini --optimize -p=0,Parameters -g=4 -z=50
+ * Relative configuration paths are relative to the suite file. Optimized parameters are never saved.
+ * Without a suite path, the fixed suite of bench/suite.txt runs, so that the reports of different commits compare.
+ * Results are tab-separated lines of case, metric, median value and unit, so that builds compare by a diff.
+ */
+
+#include "../src/utils.h"
+#include "../src/options.h"
+#include "../src/optimize.h"
+#include "../src/execute.h"
+#include "../src/batch.h"
+#include "../src/db_access.h"
+
+#include <scgms/rtl/scgmsLib.h>
+#include <scgms/utils/string_utils.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#ifndef BENCH_DEFAULT_SUITE
+	#define BENCH_DEFAULT_SUITE "bench/suite.txt"	//the build sets the absolute path within the source tree
+#endif
+
+struct TBench_Case {
+	std::wstring name;
+	std::vector<std::string> arguments;	//argv, including the program name
+};
+
+struct TBench_Sample {
+	double load_time = 0.0;				//seconds
+	double run_time = 0.0;				//seconds
+	size_t events = 0;
+	size_t objective_evaluations = 0;
+	bool ok = false;
+};
+
+double Median(std::vector<double> values) {
+	if (values.empty())
+		return std::numeric_limits<double>::quiet_NaN();
+
+	std::sort(values.begin(), values.end());
+	const size_t middle = values.size() / 2;
+	return values.size() % 2 == 1 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+std::tuple<bool, std::vector<TBench_Case>> Load_Bench_Suite(const std::wstring& suite_path) {
+	std::tuple<bool, std::vector<TBench_Case>> result{ false, {} };
+
+	std::wifstream suite_file{ filesystem::path{ suite_path } };
+	if (!suite_file) {
+		std::wcerr << L"Cannot open the benchmark suite " << suite_path << std::endl;
+		return result;
+	}
+
+	const auto suite_dir = filesystem::path{ Make_Absolute_Path(suite_path, filesystem::current_path()) }.parent_path();
+
+	std::wstring line;
+	while (std::getline(suite_file, line)) {
+		const auto tokens = Split_Manifest_Line(line);
+		if (tokens.empty() || (tokens[0][0] == L'#'))
+			continue;
+
+		TBench_Case bench_case;
+		bench_case.name = line;
+		bench_case.arguments.push_back("scgms-console-bench");
+		bench_case.arguments.push_back(Narrow_WString(Make_Absolute_Path(tokens[0], suite_dir).wstring()));
+		for (size_t i = 1; i < tokens.size(); i++)
+			bench_case.arguments.push_back(Narrow_WString(tokens[i]));
+
+		std::get<1>(result).push_back(bench_case);
+	}
+
+	std::get<0>(result) = true;
+	return result;
+}
+
+TBench_Sample Run_Bench_Case(const TBench_Case& bench_case) {
+	TBench_Sample sample;
+
+	std::vector<const char*> argv;
+	for (const auto& argument : bench_case.arguments)
+		argv.push_back(argument.c_str());
+
+	TAction action = Parse_Options(static_cast<int>(argv.size()), argv.data());
+	if ((action.action != NAction::execute) && (action.action != NAction::optimize)) {
+		std::wcerr << L"Benchmark supports execute and optimize cases only: " << bench_case.name << std::endl;
+		return sample;
+	}
+
+	action.save_config = false;
+	action.discard_result = true;
+
+	const auto load_start = std::chrono::steady_clock::now();
+	auto [rc, configuration] = Load_Experimental_Setup(action.config_path, action.variables);
+	sample.load_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+	if (!Succeeded(rc))
+		return sample;
+
+	solver::TSolver_Progress progress = solver::Null_Solver_Progress;
+	const auto run_start = std::chrono::steady_clock::now();
+
+	if (action.action == NAction::execute) {
+		CEvent_Counter event_counter;
+		sample.ok = Execute_Configuration(configuration, false, progress, &event_counter) == 0;
+		sample.events = event_counter.count();
+	}
+	else {
+		TOptimization_Stats stats;
+		sample.ok = Optimize_Configuration(configuration, action, progress, &stats) == 0;
+		sample.objective_evaluations = stats.objective_evaluations;
+	}
+
+	sample.run_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+
+	return sample;
+}
+
+int Run_Bench(int argc, char** argv) {
+
+	if (!scgms::is_scgms_loaded()) {
+		std::wcerr << L"SmartCGMS library is not loaded!" << std::endl;
+		return __LINE__;
+	}
+
+	size_t repeat_count = 3;
+	if (argc > 2) {
+		bool ok = false;
+		repeat_count = str_2_uint(argv[2], ok);
+		if (!ok || (repeat_count == 0)) {
+			std::wcerr << L"Cannot resolve repeat count to a positive number!" << std::endl;
+			return __LINE__;
+		}
+	}
+
+	auto [suite_ok, bench_cases] = Load_Bench_Suite(Widen_Char(argc > 1 ? argv[1] : BENCH_DEFAULT_SUITE));
+	if (!suite_ok)
+		return __LINE__;
+
+	std::vector<std::wstring> report;
+	bool all_ok = true;
+
+	for (size_t case_index = 0; case_index < bench_cases.size(); case_index++) {
+		const auto& bench_case = bench_cases[case_index];
+
+		std::vector<double> load_times, run_times, events_per_second, evaluations_per_second;
+		for (size_t repetition = 0; repetition < repeat_count; repetition++) {
+			const TBench_Sample sample = Run_Bench_Case(bench_case);
+			if (!sample.ok) {
+				all_ok = false;
+				break;
+			}
+
+			load_times.push_back(sample.load_time);
+			run_times.push_back(sample.run_time);
+			if (sample.run_time > 0.0) {
+				events_per_second.push_back(static_cast<double>(sample.events) / sample.run_time);
+				evaluations_per_second.push_back(static_cast<double>(sample.objective_evaluations) / sample.run_time);
+			}
+		}
+
+		const std::wstring case_name = std::to_wstring(case_index);
+		auto add_line = [&](const wchar_t* metric, const double value, const wchar_t* unit) {
+			report.push_back(case_name + L'\t' + metric + L'\t' + std::to_wstring(value) + L'\t' + unit);
+		};
+
+		add_line(L"config_load", Median(load_times) * 1000.0, L"ms");
+		add_line(L"run", Median(run_times) * 1000.0, L"ms");
+		add_line(L"events", Median(events_per_second), L"1/s");
+		add_line(L"objective_evaluations", Median(evaluations_per_second), L"1/s");
+	}
+
+	std::wcout << std::endl << L"case\tmetric\tvalue\tunit" << std::endl;
+	for (size_t case_index = 0; case_index < bench_cases.size(); case_index++)
+		std::wcout << L"# " << case_index << L": " << bench_cases[case_index].name << std::endl;
+	for (const auto& line : report)
+		std::wcout << line << std::endl;
+	std::wcout << L"all\tpeak_rss\t" << static_cast<double>(Peak_Memory_Usage()) / (1024.0 * 1024.0) << L"\tMiB" << std::endl;
+
+	return all_ok ? 0 : __LINE__;
+}
+
+int MainCalling main(int argc, char** argv) {
+	CLazy_DB_Access db_access{ argc, argv };	//Qt starts with the first filter, which needs a database
+	return db_access.Run([&]() { return Run_Bench(argc, argv); });
+}
@@ -0,0 +1,406 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "affinity.h"
+
+#include "utils.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+#include <scgms/utils/string_utils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+	#include <Windows.h>
+#else
+	#include <ctime>
+	#ifdef __linux__
+		#include <pthread.h>
+		#include <sched.h>
+	#endif
+#endif
+
+std::vector<size_t> Worker_CPUs;				//placement of the worker threads, empty leaves it to the operating system
+std::atomic<size_t> Next_Worker_Slot{ 0 };		//consecutive workers, even of concurrent pools, take consecutive slots
+
+struct TWorker_Utilization {
+	size_t threads = 0;
+	size_t tasks = 0;
+	double cpu_time = 0.0;	//seconds
+	double wall_time = 0.0;	//seconds
+};
+
+std::mutex Worker_Utilization_Guard;
+std::map<size_t, TWorker_Utilization> Worker_Utilization;
+
+bool Parse_CPU_List(const std::string& list_str, std::vector<size_t>& cpus) {
+	std::vector<size_t> result;
+
+	size_t range_begin = 0;
+	while (range_begin < list_str.size()) {
+		size_t range_end = list_str.find(',', range_begin);
+		if (range_end == std::string::npos)
+			range_end = list_str.size();
+
+		const std::string range = list_str.substr(range_begin, range_end - range_begin);
+		const auto dash_pos = range.find('-');
+
+		bool first_ok = false, last_ok = true;
+		const size_t first = str_2_uint(range.substr(0, dash_pos).c_str(), first_ok);
+		const size_t last = dash_pos == std::string::npos ? first : str_2_uint(range.substr(dash_pos + 1).c_str(), last_ok);
+		if (!first_ok || !last_ok || (last < first))
+			return false;
+
+		for (size_t cpu = first; cpu <= last; cpu++)
+			result.push_back(cpu);
+
+		range_begin = range_end + 1;
+	}
+
+	if (result.empty())
+		return false;
+
+	cpus = std::move(result);
+	return true;
+}
+
+double Thread_CPU_Time() {
+#ifdef _WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+		return 0.0;
+
+	auto to_seconds = [](const FILETIME& time) {
+		return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7;	//100 ns units
+	};
+	return to_seconds(kernel_time) + to_seconds(user_time);
+#else
+	timespec time;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+		return 0.0;
+	return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+}
+
+#if defined(_WIN32)
+
+std::vector<size_t> Mask_To_CPUs(const DWORD_PTR mask) {
+	std::vector<size_t> cpus;
+	for (size_t cpu = 0; cpu < sizeof(mask) * 8; cpu++)
+		if (mask & (static_cast<DWORD_PTR>(1) << cpu))
+			cpus.push_back(cpu);
+	return cpus;
+}
+
+DWORD_PTR CPUs_To_Mask(const std::vector<size_t>& cpus) {
+	DWORD_PTR mask = 0;
+	for (const size_t cpu : cpus)
+		if (cpu < sizeof(mask) * 8)		//the first processor group only
+			mask |= static_cast<DWORD_PTR>(1) << cpu;
+	return mask;
+}
+
+std::vector<size_t> Process_CPUs() {
+	DWORD_PTR process_mask = 0, system_mask = 0;
+	return GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) ? Mask_To_CPUs(process_mask) : std::vector<size_t>{};
+}
+
+size_t NUMA_Node_Count() {
+	ULONG highest_node = 0;
+	return GetNumaHighestNodeNumber(&highest_node) ? static_cast<size_t>(highest_node) + 1 : 1;
+}
+
+std::vector<size_t> NUMA_Node_CPUs(const size_t node) {
+	ULONGLONG mask = 0;
+	return GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask) ? Mask_To_CPUs(static_cast<DWORD_PTR>(mask)) : std::vector<size_t>{};
+}
+
+bool Restrict_Process(const std::vector<size_t>& cpus) {
+	return SetProcessAffinityMask(GetCurrentProcess(), CPUs_To_Mask(cpus)) != FALSE;
+}
+
+bool Set_Thread_CPUs(const std::vector<size_t>& cpus, std::vector<size_t>& previous_cpus) {
+	const DWORD_PTR previous_mask = SetThreadAffinityMask(GetCurrentThread(), CPUs_To_Mask(cpus));
+	previous_cpus = Mask_To_CPUs(previous_mask);
+	return previous_mask != 0;
+}
+
+#elif defined(__linux__)
+
+std::vector<size_t> Set_To_CPUs(const cpu_set_t& set) {
+	std::vector<size_t> cpus;
+	for (size_t cpu = 0; cpu < CPU_SETSIZE; cpu++)
+		if (CPU_ISSET(cpu, &set))
+			cpus.push_back(cpu);
+	return cpus;
+}
+
+cpu_set_t CPUs_To_Set(const std::vector<size_t>& cpus) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (const size_t cpu : cpus)
+		if (cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	return set;
+}
+
+std::vector<size_t> Process_CPUs() {
+	cpu_set_t set;
+	return sched_getaffinity(0, sizeof(set), &set) == 0 ? Set_To_CPUs(set) : std::vector<size_t>{};
+}
+
+std::vector<size_t> Read_Sysfs_CPU_List(const std::string& path) {
+	std::ifstream list_file{ path };
+	std::string list_str;
+	std::vector<size_t> cpus;
+	if (std::getline(list_file, list_str))
+		Parse_CPU_List(list_str, cpus);
+	return cpus;
+}
+
+size_t NUMA_Node_Count() {
+	const auto nodes = Read_Sysfs_CPU_List("/sys/devices/system/node/online");	//the same list format as for CPUs
+	return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+std::vector<size_t> NUMA_Node_CPUs(const size_t node) {
+	return Read_Sysfs_CPU_List("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+}
+
+bool Restrict_Process(const std::vector<size_t>& cpus) {
+	//sched_setaffinity restricts a single thread, whose new threads inherit it, so the calling console thread restricts the solvers' threads;
+	//the threads, which already run, e.g.; the main thread waiting to create Qt for the database access, are restricted one by one
+	const cpu_set_t set = CPUs_To_Set(cpus);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		return false;
+
+	std::error_code ec;
+	for (const auto& task : filesystem::directory_iterator{ "/proc/self/task", ec }) {
+		bool ok = false;
+		const pid_t thread_id = static_cast<pid_t>(str_2_uint(task.path().filename().string().c_str(), ok));
+		if (ok)
+			sched_setaffinity(thread_id, sizeof(set), &set);	//a thread may have finished meanwhile
+	}
+
+	return true;
+}
+
+bool Set_Thread_CPUs(const std::vector<size_t>& cpus, std::vector<size_t>& previous_cpus) {
+	cpu_set_t previous_set;
+	if (pthread_getaffinity_np(pthread_self(), sizeof(previous_set), &previous_set) == 0)
+		previous_cpus = Set_To_CPUs(previous_set);
+
+	const cpu_set_t set = CPUs_To_Set(cpus);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#else
+
+//no thread placement on this platform, just the utilization report
+std::vector<size_t> Process_CPUs() { return {}; }
+size_t NUMA_Node_Count() { return 1; }
+std::vector<size_t> NUMA_Node_CPUs(const size_t node) { return {}; }
+bool Restrict_Process(const std::vector<size_t>& cpus) { return false; }
+bool Set_Thread_CPUs(const std::vector<size_t>& cpus, std::vector<size_t>& previous_cpus) { return false; }
+
+#endif
+
+bool Configure_Affinity(const TAction& action) {
+	if ((action.affinity == NAffinity::none) && (action.numa_node == std::numeric_limits<size_t>::max()))
+		return true;
+
+	std::vector<size_t> allowed_cpus = Process_CPUs();
+	if (allowed_cpus.empty()) {
+		std::wcerr << L"Thread placement is not supported on this platform!" << std::endl;
+		return false;
+	}
+
+	//1. NUMA node restricts the whole process
+	if (action.numa_node != std::numeric_limits<size_t>::max()) {
+		const auto node_cpus = NUMA_Node_CPUs(action.numa_node);
+		std::vector<size_t> restricted_cpus;
+		std::copy_if(allowed_cpus.begin(), allowed_cpus.end(), std::back_inserter(restricted_cpus), [&](const size_t cpu) {
+			return std::find(node_cpus.begin(), node_cpus.end(), cpu) != node_cpus.end();
+		});
+
+		if (restricted_cpus.empty() || !Restrict_Process(restricted_cpus)) {
+			std::wcerr << L"Cannot restrict the process to the NUMA node " << action.numa_node << L'!' << std::endl;
+			return false;
+		}
+
+		allowed_cpus = std::move(restricted_cpus);
+	}
+
+	//2. order the CPUs, which the workers take one by one
+	switch (action.affinity) {
+		case NAffinity::list:
+		{
+			//CPUs outside the process' affinity, e.g.; of another NUMA node, or beyond the machine, would fail the placement silently
+			std::vector<size_t> dropped_cpus;
+			for (const size_t cpu : action.affinity_cpus) {
+				if (std::find(allowed_cpus.begin(), allowed_cpus.end(), cpu) != allowed_cpus.end())
+					Worker_CPUs.push_back(cpu);
+				else
+					dropped_cpus.push_back(cpu);
+			}
+
+			if (!dropped_cpus.empty()) {
+				std::wcerr << L"Ignoring CPUs, which the process may not run on:";
+				for (const size_t cpu : dropped_cpus)
+					std::wcerr << L' ' << cpu;
+				std::wcerr << std::endl;
+			}
+
+			if (Worker_CPUs.empty()) {
+				std::wcerr << L"None of the listed CPUs is available to the process!" << std::endl;
+				return false;
+			}
+			break;
+		}
+
+		case NAffinity::compact:
+		case NAffinity::scatter:
+		{
+			std::vector<std::vector<size_t>> nodes;
+			for (size_t node = 0; node < NUMA_Node_Count(); node++) {
+				const auto node_cpus = NUMA_Node_CPUs(node);
+				std::vector<size_t> allowed_node_cpus;
+				std::copy_if(allowed_cpus.begin(), allowed_cpus.end(), std::back_inserter(allowed_node_cpus), [&](const size_t cpu) {
+					return std::find(node_cpus.begin(), node_cpus.end(), cpu) != node_cpus.end();
+				});
+
+				if (!allowed_node_cpus.empty())
+					nodes.push_back(allowed_node_cpus);
+			}
+
+			if (nodes.empty())
+				nodes.push_back(allowed_cpus);	//unknown topology makes a single node
+
+			if (action.affinity == NAffinity::compact) {
+				for (const auto& node : nodes)
+					Worker_CPUs.insert(Worker_CPUs.end(), node.begin(), node.end());
+			}
+			else {
+				//the node lists hold the allowed CPUs only, so the largest one bounds the rounds, however the nodes cover the allowed CPUs
+				size_t largest_node_size = 0;
+				for (const auto& node : nodes)
+					largest_node_size = std::max(largest_node_size, node.size());
+
+				for (size_t i = 0; i < largest_node_size; i++)
+					for (const auto& node : nodes)
+						if (i < node.size())
+							Worker_CPUs.push_back(node[i]);
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	if (!Worker_CPUs.empty()) {
+		std::wcout << L"Worker threads are placed on CPUs:";
+		for (const size_t cpu : Worker_CPUs)
+			std::wcout << L' ' << cpu;
+		std::wcout << std::endl;
+	}
+
+	return true;
+}
+
+CWorker_Scope::CWorker_Scope() {
+	const size_t slot_count = Worker_CPUs.empty() ? Resolve_Worker_Count(0) : Worker_CPUs.size();
+	mSlot = Next_Worker_Slot++ % slot_count;
+
+	if (!Worker_CPUs.empty() && !Set_Thread_CPUs({ Worker_CPUs[mSlot] }, mPrevious_CPUs))
+		mPrevious_CPUs.clear();
+
+	mStart_Time = std::chrono::steady_clock::now();
+	mStart_CPU_Time = Thread_CPU_Time();
+
+	std::lock_guard<std::mutex> lock{ Worker_Utilization_Guard };
+	Worker_Utilization[mSlot].threads++;
+}
+
+CWorker_Scope::~CWorker_Scope() {
+	Flush();
+
+	if (!mPrevious_CPUs.empty()) {
+		std::vector<size_t> pinned_cpus;
+		Set_Thread_CPUs(mPrevious_CPUs, pinned_cpus);
+	}
+}
+
+void CWorker_Scope::Flush() {
+	const auto now = std::chrono::steady_clock::now();
+	const double now_cpu_time = Thread_CPU_Time();
+
+	std::lock_guard<std::mutex> lock{ Worker_Utilization_Guard };
+	auto& utilization = Worker_Utilization[mSlot];
+	utilization.tasks += mTasks;
+	utilization.cpu_time += now_cpu_time - mStart_CPU_Time;
+	utilization.wall_time += std::chrono::duration<double>(now - mStart_Time).count();
+
+	mTasks = 0;
+	mStart_Time = now;
+	mStart_CPU_Time = now_cpu_time;
+}
+
+void Report_Worker_Utilization() {
+	std::lock_guard<std::mutex> lock{ Worker_Utilization_Guard };
+	if (Worker_Utilization.empty())
+		return;
+
+	const auto precision = std::wcout.precision();
+	std::wcout << std::endl << L"Worker utilization (slot, CPU, threads, tasks, CPU s, wall s, busy %):" << std::endl;
+	for (const auto& [slot, utilization] : Worker_Utilization) {
+		std::wcout << slot << L'\t';
+		if (Worker_CPUs.empty())
+			std::wcout << L'-';
+		else
+			std::wcout << Worker_CPUs[slot];
+
+		const double busy = utilization.wall_time > 0.0 ? 100.0 * utilization.cpu_time / utilization.wall_time : 0.0;
+		std::wcout << L'\t' << utilization.threads << L'\t' << utilization.tasks << L'\t' << std::fixed << std::setprecision(3)
+			<< utilization.cpu_time << L'\t' << utilization.wall_time << L'\t' << std::setprecision(1) << busy << std::defaultfloat << std::setprecision(precision) << std::endl;
+	}
+}
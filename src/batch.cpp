@@ -0,0 +1,238 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "batch.h"
+
+#include "execute.h"
+#include "utils.h"
+#include "cancellation.h"
+
+#include <scgms/utils/string_utils.h>
+
+#include <fstream>
+#include <chrono>
+#include <map>
+#include <iostream>
+#include <mutex>
+
+std::vector<std::wstring> Split_Manifest_Line(const std::wstring& line) {
+	std::vector<std::wstring> tokens;
+	std::wstring token;
+	bool quoted = false, has_token = false;
+
+	for (const wchar_t ch : line) {
+		if (ch == L'"') {
+			quoted = !quoted;
+			has_token = true;	//allows to pass an empty string as ""
+		}
+		else if (!quoted && iswspace(ch)) {
+			if (has_token)
+				tokens.push_back(token);
+			token.clear();
+			has_token = false;
+		}
+		else {
+			token += ch;
+			has_token = true;
+		}
+	}
+
+	if (has_token)
+		tokens.push_back(token);
+
+	return tokens;
+}
+
+std::tuple<bool, std::vector<TBatch_Job>> Load_Batch_Manifest(const std::wstring& manifest_path) {
+	std::tuple<bool, std::vector<TBatch_Job>> result{ false, {} };
+
+	std::wifstream manifest_file{ filesystem::path{ manifest_path } };
+	if (!manifest_file) {
+		std::wcerr << L"Cannot open the batch manifest " << manifest_path << std::endl;
+		return result;
+	}
+
+	//relative configuration paths are relative to the manifest
+	const auto manifest_dir = filesystem::path{ Make_Absolute_Path(manifest_path, filesystem::current_path()) }.parent_path();
+
+	auto& jobs = std::get<1>(result);
+	std::wstring line;
+	size_t line_counter = 0;
+	while (std::getline(manifest_file, line)) {
+		line_counter++;
+
+		const auto tokens = Split_Manifest_Line(line);
+		if (tokens.empty() || (tokens[0][0] == L'#'))	//empty line or comment
+			continue;
+
+		TBatch_Job job;
+		job.line_number = line_counter;
+		job.config_path = Make_Absolute_Path(tokens[0], manifest_dir).wstring();
+
+		for (size_t i = 1; i < tokens.size(); i++) {
+			std::wstring var_str;
+			const std::wstring& token = tokens[i];
+
+			if ((token == L"-v") || (token == L"--variable")) {
+				if (++i < tokens.size())
+					var_str = tokens[i];
+			}
+			else if (token.rfind(L"-v=", 0) == 0)
+				var_str = token.substr(3);
+			else if (token.rfind(L"--variable=", 0) == 0)
+				var_str = token.substr(11);
+			else {
+				std::wcerr << L"Line no. " << line_counter << L" of the batch manifest contains an unknown option " << token << std::endl;
+				return result;
+			}
+
+			TVariable var_to_set;
+			if (!Parse_Variable(var_str, var_to_set)) {
+				std::wcerr << L"Line no. " << line_counter << L" of the batch manifest contains a malformed variable: " << var_str << std::endl;
+				return result;
+			}
+
+			job.variables.push_back(var_to_set);
+		}
+
+		jobs.push_back(job);
+	}
+
+	std::get<0>(result) = true;
+	return result;
+}
+
+int Execute_Batch(const TAction& action, solver::TSolver_Progress& progress) {
+	auto [manifest_ok, jobs] = Load_Batch_Manifest(action.config_path);
+	if (!manifest_ok)
+		return __LINE__;
+
+	if (jobs.empty()) {
+		std::wcerr << L"The batch manifest " << action.config_path << L" contains no jobs!" << std::endl;
+		return __LINE__;
+	}
+
+	//with a warm configuration, each distinct file is read just once and every job instantiates it from memory
+	std::map<std::wstring, TConfiguration_Image> configuration_images;
+	double image_load_time = 0.0;
+	if (action.warm_config) {
+		const auto load_start = std::chrono::steady_clock::now();
+		for (const auto& job : jobs) {
+			if (configuration_images.find(job.config_path) != configuration_images.end())
+				continue;
+
+			auto [image_ok, image] = Load_Configuration_Image(job.config_path);
+			if (!image_ok)
+				return __LINE__;
+
+			configuration_images.emplace(job.config_path, std::move(image));
+		}
+		image_load_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+
+		std::wcout << L"Loaded " << configuration_images.size() << L" configurations in " << image_load_time * 1000.0 << L" ms." << std::endl;
+	}
+
+	const size_t worker_count = std::min(jobs.size(), Resolve_Worker_Count(action.worker_count));
+	std::wcout << L"Executing " << jobs.size() << L" jobs using " << worker_count << L" workers." << std::endl;
+
+	std::vector<int> exit_codes(jobs.size(), __LINE__);
+	std::vector<double> load_times(jobs.size(), 0.0), run_times(jobs.size(), 0.0);	//seconds
+	std::mutex report_guard;
+
+	Parallel_For(jobs.size(), worker_count, [&](const size_t job_index) {
+		if (progress.cancelled != FALSE)
+			return;	//do not start any new job once the user has cancelled the batch
+
+		const TBatch_Job& job = jobs[job_index];
+
+		//command-line variables apply to all jobs, while the manifest ones may override them
+		std::vector<TVariable> variables = action.variables;
+		variables.insert(variables.end(), job.variables.begin(), job.variables.end());
+
+		int exit_code = __LINE__;
+		bool timed_out = false;
+		const auto load_start = std::chrono::steady_clock::now();
+		auto [rc, configuration] = action.warm_config ?
+			Instantiate_Configuration(configuration_images.at(job.config_path), variables) :
+			Load_Experimental_Setup(job.config_path, variables);
+		const auto run_start = std::chrono::steady_clock::now();
+
+		if (Succeeded(rc)) {
+			solver::TSolver_Progress job_progress = solver::Null_Solver_Progress;
+			job_progress.cancelled = progress.cancelled;
+			CRun_Budget budget{ job_progress, action.timeout };
+			exit_code = Execute_Configuration(configuration, action.save_config, job_progress);
+			timed_out = budget.exhausted();
+		}
+
+		exit_codes[job_index] = exit_code;
+		load_times[job_index] = std::chrono::duration<double>(run_start - load_start).count();
+		run_times[job_index] = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+
+		const wchar_t* outcome = exit_code == 0 ? L"succeeded." : L"failed.";
+		if (exit_code == Cancelled_Exit_Code)
+			outcome = timed_out ? L"timed out." : L"was cancelled.";
+
+		std::lock_guard<std::mutex> lock{ report_guard };
+		std::wcout << L"Job " << job_index + 1 << L'/' << jobs.size() << L" (" << job.config_path << L") " << outcome << std::endl;
+	});
+
+	size_t failed_count = 0, cancelled_count = 0;
+	double total_load_time = image_load_time, total_run_time = 0.0;
+	std::wcout << std::endl << L"Batch summary (manifest line, exit code, load ms, run ms, configuration):" << std::endl;
+	for (size_t i = 0; i < jobs.size(); i++) {
+		std::wcout << jobs[i].line_number << L'\t' << exit_codes[i] << L'\t' << load_times[i] * 1000.0 << L'\t' << run_times[i] * 1000.0 << L'\t' << jobs[i].config_path << std::endl;
+		if (exit_codes[i] != 0)
+			failed_count++;
+		if (exit_codes[i] == Cancelled_Exit_Code)
+			cancelled_count++;
+
+		total_load_time += load_times[i];
+		total_run_time += run_times[i];
+	}
+
+	std::wcout << L"Total load time " << total_load_time * 1000.0 << L" ms, total run time " << total_run_time * 1000.0 << L" ms." << std::endl;
+
+	if (progress.cancelled != FALSE)
+		std::wcerr << L"The batch was cancelled." << std::endl;
+
+	std::wcout << jobs.size() - failed_count << L" of " << jobs.size() << L" jobs succeeded";
+	if (cancelled_count > 0)
+		std::wcout << L", " << cancelled_count << L" were cancelled or timed out";
+	std::wcout << L'.' << std::endl;
+
+	return failed_count == 0 ? 0 : __LINE__;
+}
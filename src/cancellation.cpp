@@ -0,0 +1,183 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "cancellation.h"
+
+#include "execute.h"
+
+#include <csignal>
+#include <iostream>
+
+#ifdef _WIN32
+	#include <Windows.h>
+#else
+	#include <cerrno>
+	#include <unistd.h>
+#endif
+
+constexpr std::chrono::milliseconds Evaluation_Check_Period{ 20 };	//how promptly an exhausted evaluation budget cancels the run
+
+#ifdef _WIN32
+
+CSignal_Watcher* Active_Signal_Watcher = nullptr;
+
+BOOL WINAPI Console_Control_Handler(DWORD control_type) {
+	//console control handlers run on their own thread, so they may cancel right away
+	if ((control_type == CTRL_C_EVENT) || (control_type == CTRL_BREAK_EVENT) || (control_type == CTRL_CLOSE_EVENT)) {
+		if (Active_Signal_Watcher)
+			Active_Signal_Watcher->Cancel();
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+CSignal_Watcher::CSignal_Watcher(solver::TSolver_Progress& progress) : mProgress(progress) {
+	Active_Signal_Watcher = this;
+	SetConsoleCtrlHandler(Console_Control_Handler, TRUE);
+}
+
+CSignal_Watcher::~CSignal_Watcher() {
+	SetConsoleCtrlHandler(Console_Control_Handler, FALSE);
+	Active_Signal_Watcher = nullptr;
+}
+
+#else
+
+volatile sig_atomic_t Signal_Pipe_Write_End = -1;
+
+void Signal_Handler(int signo) {
+	//write is async-signal-safe, unlike anything the cancellation does
+	const int saved_errno = errno;
+	const char code = static_cast<char>(signo);
+	if (write(Signal_Pipe_Write_End, &code, 1) < 0) {
+		//nothing to do about it here
+	}
+	errno = saved_errno;
+}
+
+CSignal_Watcher::CSignal_Watcher(solver::TSolver_Progress& progress) : mProgress(progress) {
+	if (pipe(mSignal_Pipe) != 0) {
+		std::wcerr << L"Cannot install the signal handlers, the run cannot be cancelled!" << std::endl;
+		return;
+	}
+
+	mWatcher = std::thread{ [this]() {
+		char code = 0;
+		while (true) {
+			const auto received = read(mSignal_Pipe[0], &code, 1);
+			if ((received < 0) && (errno == EINTR))
+				continue;
+			if ((received <= 0) || (code == 0))
+				break;	//zero code stops the watcher
+
+			Cancel();
+		}
+	} };
+
+	Signal_Pipe_Write_End = mSignal_Pipe[1];
+	signal(SIGINT, Signal_Handler);
+	signal(SIGTERM, Signal_Handler);	//a preempted optimization can still write its checkpoint
+}
+
+CSignal_Watcher::~CSignal_Watcher() {
+	if (!mWatcher.joinable())
+		return;
+
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	Signal_Pipe_Write_End = -1;
+
+	const char stop_code = 0;
+	if (write(mSignal_Pipe[1], &stop_code, 1) == 1)
+		mWatcher.join();
+	else
+		mWatcher.detach();
+
+	close(mSignal_Pipe[0]);
+	close(mSignal_Pipe[1]);
+}
+
+#endif
+
+void CSignal_Watcher::Cancel() {
+	std::wcout << std::endl << "Cancelling..." << std::endl;
+
+	mProgress.cancelled = TRUE;
+	Cancel_All_Executions();
+}
+
+CRun_Budget::CRun_Budget(solver::TSolver_Progress& progress, const double timeout, const size_t max_evaluations, const std::atomic<size_t>* evaluations)
+	: mProgress(progress), mEvaluations(evaluations), mMax_Evaluations(evaluations ? max_evaluations : 0),
+	mDeadline(timeout > 0.0 ? std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>{ timeout }) : std::chrono::steady_clock::time_point::max()) {
+
+	if ((timeout <= 0.0) && (mMax_Evaluations == 0))
+		return;	//unlimited
+
+	mWatchdog = std::thread{ [this]() {
+		std::unique_lock<std::mutex> lock{ mStop_Guard };
+		while (!mStop) {
+			//time budget alone needs no polling, but the evaluation count does
+			const auto wake_up = mMax_Evaluations > 0 ? std::min(mDeadline, std::chrono::steady_clock::now() + Evaluation_Check_Period) : mDeadline;
+			mStop_Signal.wait_until(lock, wake_up, [this]() { return mStop; });
+
+			if (!mStop && Is_Exhausted()) {
+				mExhausted = true;
+				std::wcout << std::endl << L"The run has exhausted its budget, cancelling..." << std::endl;
+				Cancel_Execution(mProgress);
+				break;
+			}
+		}
+	} };
+}
+
+CRun_Budget::~CRun_Budget() {
+	{
+		std::lock_guard<std::mutex> lock{ mStop_Guard };
+		mStop = true;
+	}
+	mStop_Signal.notify_all();
+
+	if (mWatchdog.joinable())
+		mWatchdog.join();
+}
+
+bool CRun_Budget::Is_Exhausted() const {
+	if (std::chrono::steady_clock::now() >= mDeadline)
+		return true;
+
+	return (mMax_Evaluations > 0) && (*mEvaluations >= mMax_Evaluations);
+}
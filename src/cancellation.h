@@ -0,0 +1,85 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/SolverLib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// cancels the progress and all running executions on SIGINT and SIGTERM; the signal handler just writes
+// to a self-pipe, as the stream I/O and locking of the cancellation are not async-signal-safe
+class CSignal_Watcher {
+protected:
+	solver::TSolver_Progress& mProgress;
+	std::thread mWatcher;
+#ifndef _WIN32
+	int mSignal_Pipe[2] = { -1, -1 };
+#endif
+public:
+	CSignal_Watcher(solver::TSolver_Progress& progress);
+	~CSignal_Watcher();
+
+	void Cancel();	//what a delivered signal does
+};
+
+// cancels the progress, once the run exceeds its wall-clock time or its number of objective evaluations;
+// zero means no limit, and a cancelled optimization still keeps the best solution found so far
+class CRun_Budget {
+protected:
+	solver::TSolver_Progress& mProgress;
+	const std::atomic<size_t>* mEvaluations;
+	const size_t mMax_Evaluations;
+	const std::chrono::steady_clock::time_point mDeadline;
+
+	std::mutex mStop_Guard;
+	std::condition_variable mStop_Signal;
+	bool mStop = false;
+	std::atomic<bool> mExhausted{ false };
+	std::thread mWatchdog;
+
+	bool Is_Exhausted() const;
+public:
+	CRun_Budget(solver::TSolver_Progress& progress, const double timeout, const size_t max_evaluations = 0, const std::atomic<size_t>* evaluations = nullptr);
+	~CRun_Budget();
+
+	bool exhausted() const { return mExhausted; }
+};
@@ -0,0 +1,126 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "checkpoint.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+#include <scgms/utils/string_utils.h>
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+const char* Completed_Generations_Key = "# completed_generations=";
+const char* Best_Metric_Key = "# best_metric=";
+
+bool Write_Checkpoint(const std::wstring& checkpoint_path, const TCheckpoint& checkpoint) {
+	const filesystem::path final_path{ checkpoint_path };
+	filesystem::path temporary_path{ final_path };
+	temporary_path += L".tmp";
+
+	{
+		std::ofstream checkpoint_file{ temporary_path, std::ios::trunc };
+		checkpoint_file << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+		checkpoint_file << "# SmartCGMS console optimization checkpoint" << std::endl;
+		checkpoint_file << Completed_Generations_Key << checkpoint.completed_generations << std::endl;
+
+		checkpoint_file << Best_Metric_Key;
+		for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++)
+			checkpoint_file << (i > 0 ? " " : "") << checkpoint.best_metric[i];
+		checkpoint_file << std::endl;
+
+		for (size_t i = 0; i < checkpoint.parameters.size(); i++)
+			checkpoint_file << (i > 0 ? " " : "") << checkpoint.parameters[i];
+		checkpoint_file << std::endl;
+
+		if (!checkpoint_file) {
+			std::wcerr << L"Cannot write the checkpoint " << temporary_path.wstring() << std::endl;
+			return false;
+		}
+	}
+
+	//rename replaces the previous checkpoint at once, so a crash cannot leave a partial file behind
+	std::error_code ec;
+	filesystem::rename(temporary_path, final_path, ec);
+	if (ec) {
+		std::wcerr << L"Cannot replace the checkpoint " << checkpoint_path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Read_Checkpoint(const std::wstring& checkpoint_path, TCheckpoint& checkpoint) {
+	std::ifstream checkpoint_file{ filesystem::path{ checkpoint_path } };
+	if (!checkpoint_file) {
+		std::wcerr << L"Cannot open the checkpoint " << checkpoint_path << std::endl;
+		return false;
+	}
+
+	const std::string generations_key{ Completed_Generations_Key }, metric_key{ Best_Metric_Key };
+	bool generations_ok = false, parameters_ok = false;
+
+	std::string line;
+	while (std::getline(checkpoint_file, line)) {
+		if (line.rfind(generations_key, 0) == 0) {
+			checkpoint.completed_generations = static_cast<size_t>(str_2_uint(line.c_str() + generations_key.size(), generations_ok));
+		}
+		else if (line.rfind(metric_key, 0) == 0) {
+			std::istringstream metric_stream{ line.substr(metric_key.size()) };
+			for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
+				std::string value;
+				if (!(metric_stream >> value))
+					break;
+
+				bool ok = false;
+				const double metric = str_2_dbl(Widen_Char(value.c_str()).c_str(), ok);
+				checkpoint.best_metric[i] = ok ? metric : std::numeric_limits<double>::quiet_NaN();
+			}
+		}
+		else if (!line.empty() && (line[0] != '#')) {
+			checkpoint.parameters = str_2_dbls(Widen_Char(line.c_str()).c_str(), parameters_ok);
+		}
+	}
+
+	if (!generations_ok || !parameters_ok) {
+		std::wcerr << L"The checkpoint " << checkpoint_path << L" is corrupted!" << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,302 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "columnar_export.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+void Append_Varint(std::vector<uint8_t>& bytes, uint64_t value) {
+	do {
+		uint8_t byte = static_cast<uint8_t>(value & 0x7F);
+		value >>= 7;
+		if (value != 0)
+			byte |= 0x80;
+		bytes.push_back(byte);
+	} while (value != 0);
+}
+
+uint64_t Double_Bits(const double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+std::vector<uint8_t> Encode_Device_Times(const std::vector<double>& device_times) {
+	std::vector<uint8_t> bytes;
+	uint64_t previous_bits = 0, previous_delta = 0;
+	for (const double device_time : device_times) {
+		//unsigned arithmetic wraps around, so the decoding is exact for any bits
+		const uint64_t bits = Double_Bits(device_time);
+		const uint64_t delta = bits - previous_bits;
+		const int64_t delta_of_delta = static_cast<int64_t>(delta - previous_delta);
+		Append_Varint(bytes, (static_cast<uint64_t>(delta_of_delta) << 1) ^ static_cast<uint64_t>(delta_of_delta >> 63));	//zigzag
+
+		previous_bits = bits;
+		previous_delta = delta;
+	}
+
+	return bytes;
+}
+
+// appends bits, the most significant first
+class CBit_Writer {
+protected:
+	std::vector<uint8_t>& mBytes;
+	size_t mFree_Bits = 0;	//in the last byte
+public:
+	CBit_Writer(std::vector<uint8_t>& bytes) : mBytes(bytes) {}
+
+	void Write(const uint64_t value, size_t bit_count) {
+		while (bit_count > 0) {
+			if (mFree_Bits == 0) {
+				mBytes.push_back(0);
+				mFree_Bits = 8;
+			}
+
+			const size_t written = std::min(bit_count, mFree_Bits);
+			const uint8_t chunk = static_cast<uint8_t>((value >> (bit_count - written)) & ((1u << written) - 1));
+			mBytes.back() |= static_cast<uint8_t>(chunk << (mFree_Bits - written));
+			mFree_Bits -= written;
+			bit_count -= written;
+		}
+	}
+};
+
+size_t Leading_Zeros(uint64_t value) {
+	size_t count = 0;
+	for (uint64_t mask = 1ULL << 63; (mask != 0) && !(value & mask); mask >>= 1)
+		count++;
+	return count;
+}
+
+size_t Trailing_Zeros(uint64_t value) {
+	size_t count = 0;
+	for (; (count < 64) && !(value & 1); value >>= 1)
+		count++;
+	return count;
+}
+
+std::vector<uint8_t> Encode_Levels(const std::vector<double>& levels) {
+	//the bits XOR-ed with the previous level keep only the meaningful bits between their leading and trailing zeros:
+	//  0 - the same level
+	//  10 - the meaningful bits fit the window of the previous level, which they follow
+	//  11 - 5 bits of leading zeros, 6 bits of the meaningful bit count (zero means 64), and the meaningful bits
+	std::vector<uint8_t> bytes;
+	CBit_Writer writer{ bytes };
+
+	uint64_t previous_bits = 0;
+	size_t window_leading = 64, window_trailing = 64;	//no window yet
+	for (const double level : levels) {
+		const uint64_t bits = Double_Bits(level);
+		const uint64_t xored = bits ^ previous_bits;
+		previous_bits = bits;
+
+		if (xored == 0) {
+			writer.Write(0, 1);
+			continue;
+		}
+
+		const size_t leading = std::min(Leading_Zeros(xored), static_cast<size_t>(31));
+		const size_t trailing = Trailing_Zeros(xored);
+		if ((window_leading + window_trailing < 64) && (leading >= window_leading) && (trailing >= window_trailing)) {
+			writer.Write(0b10, 2);
+			writer.Write(xored >> window_trailing, 64 - window_leading - window_trailing);
+		}
+		else {
+			const size_t meaningful = 64 - leading - trailing;
+			writer.Write(0b11, 2);
+			writer.Write(leading, 5);
+			writer.Write(meaningful & 0x3F, 6);
+			writer.Write(xored >> trailing, meaningful);
+
+			window_leading = leading;
+			window_trailing = trailing;
+		}
+	}
+
+	//noisy levels may not compress at all, and then the raw doubles are smaller; readers tell them by their size
+	if (bytes.size() >= levels.size() * sizeof(double)) {
+		bytes.resize(levels.size() * sizeof(double));
+		memcpy(bytes.data(), levels.data(), bytes.size());
+	}
+
+	return bytes;
+}
+
+bool CColumnar_Export::TColumns_Key_Less::operator()(const std::pair<uint64_t, GUID>& a, const std::pair<uint64_t, GUID>& b) const {
+	if (a.first != b.first)
+		return a.first < b.first;
+	return memcmp(&a.second, &b.second, sizeof(GUID)) < 0;
+}
+
+CColumnar_Export::CColumnar_Export(const std::wstring& path, const size_t max_pending) : mMax_Pending(max_pending) {
+	mFile.open(filesystem::path{ path }, std::ios::binary | std::ios::trunc);
+	if (!mFile) {
+		std::wcerr << L"Cannot open the export file " << path << std::endl;
+		return;
+	}
+
+	const TColumnar_Header header;
+	mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	mWriter = std::thread{ [this]() {
+		std::vector<TRecord> records;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock{ mPending_Guard };
+				mPending_Signal.wait(lock, [this]() { return mStop || !mPending.empty(); });
+				if (mPending.empty())
+					break;	//stopped, and all written
+
+				records.swap(mPending);	//the chain continues into the empty buffer
+			}
+
+			Write_Records(records);
+			records.clear();
+		}
+	} };
+}
+
+CColumnar_Export::~CColumnar_Export() {
+	Finish();
+}
+
+HRESULT IfaceCalling CColumnar_Export::Execute(scgms::IDevice_Event* event) {
+	scgms::UDevice_Event device_event{ event };	//releases the event
+	if ((device_event.event_code() != scgms::NDevice_Event_Code::Level) && (device_event.event_code() != scgms::NDevice_Event_Code::Masked_Level))
+		return S_OK;
+
+	const TRecord record{ device_event.signal_id(), device_event.segment_id(), device_event.device_time(), device_event.level() };
+
+	bool first_pending = false;
+	{
+		std::lock_guard<std::mutex> lock{ mPending_Guard };
+		if (mPending.size() >= mMax_Pending) {
+			mDropped++;	//never stall the chain
+			return S_OK;
+		}
+
+		mPending.push_back(record);
+		first_pending = mPending.size() == 1;
+	}
+
+	if (first_pending)
+		mPending_Signal.notify_one();
+
+	return S_OK;
+}
+
+void CColumnar_Export::Write_Records(const std::vector<TRecord>& records) {
+	for (const auto& record : records) {
+		const std::pair<uint64_t, GUID> key{ record.segment_id, record.signal_id };
+		auto& columns = mColumns[key];
+		columns.device_times.push_back(record.device_time);
+		columns.levels.push_back(record.level);
+
+		if (columns.device_times.size() >= Columnar_Chunk_Size)
+			Write_Chunk(key.first, key.second, columns);
+	}
+
+	mEvent_Count += records.size();
+}
+
+void CColumnar_Export::Write_Chunk(const uint64_t segment_id, const GUID& signal_id, TColumns& columns) {
+	const auto device_time_bytes = Encode_Device_Times(columns.device_times);
+	const auto level_bytes = Encode_Levels(columns.levels);
+
+	TColumnar_Index_Entry entry;
+	entry.segment_id = segment_id;
+	entry.signal_id = signal_id;
+	entry.offset = static_cast<uint64_t>(mFile.tellp());
+	entry.count = static_cast<uint32_t>(columns.device_times.size());
+	entry.device_time_bytes = static_cast<uint32_t>(device_time_bytes.size());
+	entry.level_bytes = static_cast<uint32_t>(level_bytes.size());
+	const auto [min_time, max_time] = std::minmax_element(columns.device_times.begin(), columns.device_times.end());
+	entry.min_device_time = *min_time;
+	entry.max_device_time = *max_time;
+
+	mFile.write(reinterpret_cast<const char*>(device_time_bytes.data()), device_time_bytes.size());
+	mFile.write(reinterpret_cast<const char*>(level_bytes.data()), level_bytes.size());
+	if (!mFile)
+		mWrite_Failed = true;
+
+	mIndex.push_back(entry);
+	columns.device_times.clear();
+	columns.levels.clear();
+}
+
+bool CColumnar_Export::Finish() {
+	if (!mWriter.joinable())
+		return !mWrite_Failed && mFile.is_open();
+
+	{
+		std::lock_guard<std::mutex> lock{ mPending_Guard };
+		mStop = true;
+	}
+	mPending_Signal.notify_one();
+	mWriter.join();
+
+	for (auto& [key, columns] : mColumns)
+		if (!columns.device_times.empty())
+			Write_Chunk(key.first, key.second, columns);
+	mColumns.clear();
+
+	std::sort(mIndex.begin(), mIndex.end(), [](const TColumnar_Index_Entry& a, const TColumnar_Index_Entry& b) {
+		if (a.segment_id != b.segment_id)
+			return a.segment_id < b.segment_id;
+		const int signal_order = memcmp(&a.signal_id, &b.signal_id, sizeof(GUID));
+		return signal_order != 0 ? signal_order < 0 : a.offset < b.offset;
+	});
+
+	TColumnar_Trailer trailer;
+	trailer.index_offset = static_cast<uint64_t>(mFile.tellp());
+	trailer.index_count = mIndex.size();
+	trailer.event_count = mEvent_Count;
+	trailer.dropped_count = mDropped;
+
+	mFile.write(reinterpret_cast<const char*>(mIndex.data()), mIndex.size() * sizeof(TColumnar_Index_Entry));
+	mFile.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+	mFile.close();
+
+	if (mFile.fail())
+		mWrite_Failed = true;
+
+	return !mWrite_Failed;
+}
@@ -0,0 +1,142 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/FilterLib.h>
+#include <scgms/rtl/referencedImpl.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Terminal filter, which writes the level events leaving the chain into a columnar binary file.
+ *
+ * The file is a header, followed by chunks and an index:
+ *   header: TColumnar_Header
+ *   chunk: device times and levels of up to Columnar_Chunk_Size events of a single segment and signal, as LEB128 varints;
+ *          device times store the zigzag delta of deltas of their bits, so regular sampling takes a byte per event,
+ *          and levels store their bits XOR-ed with the previous level as a bit stream of the meaningful bits only (see Encode_Levels),
+ *          so that a repeated level takes a bit, and a level of a few significant digits less than the 8 raw bytes;
+ *          a level column, which would not be smaller than the raw doubles, holds the raw doubles, i.e.; exactly 8 bytes per event
+ *   index: TColumnar_Index_Entry per chunk, sorted by segment and signal, followed by TColumnar_Trailer
+ * Readers seek to the trailer at the end of the file, and then to the chunks they need.
+ */
+
+constexpr size_t Columnar_Chunk_Size = 4096;
+constexpr size_t Columnar_Max_Pending = 1 << 20;	//events buffered for the writer, before the chain drops them rather than waiting
+
+#pragma pack(push, 1)
+struct TColumnar_Header {
+	char magic[8] = { 'S', 'C', 'G', 'M', 'S', 'C', 'O', 'L' };
+	uint32_t version = 2;
+};
+
+struct TColumnar_Index_Entry {
+	uint64_t segment_id = 0;
+	GUID signal_id = Invalid_GUID;
+	uint64_t offset = 0;					// of the chunk from the beginning of the file
+	uint32_t count = 0;						// events in the chunk
+	uint32_t device_time_bytes = 0;			// size of the device time column, the level column follows
+	uint32_t level_bytes = 0;
+	double min_device_time = 0.0, max_device_time = 0.0;
+};
+
+struct TColumnar_Trailer {
+	uint64_t index_offset = 0;
+	uint64_t index_count = 0;
+	uint64_t event_count = 0;
+	uint64_t dropped_count = 0;				// events dropped, because the writer could not keep up
+	char magic[8] = { 'S', 'C', 'G', 'M', 'S', 'C', 'O', 'L' };
+};
+#pragma pack(pop)
+
+class CColumnar_Export : public virtual scgms::IFilter, public virtual refcnt::CNotReferenced {
+protected:
+	struct TRecord {
+		GUID signal_id;
+		uint64_t segment_id;
+		double device_time;
+		double level;
+	};
+
+	struct TColumns {
+		std::vector<double> device_times, levels;
+	};
+
+	struct TColumns_Key_Less {
+		bool operator()(const std::pair<uint64_t, GUID>& a, const std::pair<uint64_t, GUID>& b) const;
+	};
+
+	std::ofstream mFile;
+	const size_t mMax_Pending;
+
+	//producer side, i.e.; the chain
+	std::mutex mPending_Guard;
+	std::condition_variable mPending_Signal;
+	std::vector<TRecord> mPending;
+	bool mStop = false;
+	std::atomic<size_t> mDropped{ 0 };
+
+	//writer side
+	std::thread mWriter;
+	std::map<std::pair<uint64_t, GUID>, TColumns, TColumns_Key_Less> mColumns;
+	std::vector<TColumnar_Index_Entry> mIndex;
+	uint64_t mEvent_Count = 0;
+	bool mWrite_Failed = false;
+
+	void Write_Records(const std::vector<TRecord>& records);
+	void Write_Chunk(const uint64_t segment_id, const GUID& signal_id, TColumns& columns);
+public:
+	CColumnar_Export(const std::wstring& path, const size_t max_pending);
+	virtual ~CColumnar_Export();
+
+	virtual HRESULT IfaceCalling Configure(scgms::IFilter_Configuration* configuration, refcnt::wstr_list* error_description) override final { return S_OK; }
+	virtual HRESULT IfaceCalling Execute(scgms::IDevice_Event* event) override final;
+
+	bool is_open() const { return mFile.is_open(); }
+	bool Finish();	//writes the remaining chunks and the index; false if anything has failed
+
+	uint64_t event_count() const { return mEvent_Count; }
+	size_t dropped_count() const { return mDropped; }
+};
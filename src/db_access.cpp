@@ -0,0 +1,165 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "db_access.h"
+#include "startup_timing.h"
+
+#include <scgms/rtl/DbLib.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+/*
+ *	If you do not need database access, or do not want to use Qt, then
+ *  #define DDO_NOT_USE_QT
+ */
+#ifndef DDO_NOT_USE_QT
+	#include <scgms/rtl/qdb_connector.h>
+	#include <QtCore/QCoreApplication>
+#endif
+
+std::atomic<CLazy_DB_Access*> Active_DB_Access{ nullptr };
+std::mutex DB_Access_Guard;
+
+#ifndef DDO_NOT_USE_QT
+	std::unique_ptr<QCoreApplication> DB_Application;
+#endif
+
+CLazy_DB_Access::CLazy_DB_Access(int& argc, char** argv) : mArgc(argc), mArgv(argv) {
+	Active_DB_Access = this;
+}
+
+CLazy_DB_Access::~CLazy_DB_Access() {
+	Active_DB_Access = nullptr;
+
+#ifndef DDO_NOT_USE_QT
+	std::lock_guard<std::mutex> lock{ DB_Access_Guard };
+	DB_Application.reset();
+#endif
+}
+
+void CLazy_DB_Access::Create_Application() {
+#ifndef DDO_NOT_USE_QT
+	std::lock_guard<std::mutex> lock{ DB_Access_Guard };
+	if (DB_Application)
+		return;
+
+	const auto qt_init_start = std::chrono::steady_clock::now();
+	DB_Application = std::make_unique<QCoreApplication>(mArgc, mArgv);	//needed as we expose qdb connector that uses Qt
+	Record_Startup_Phase(NStartup_Phase::qt_init, std::chrono::steady_clock::now() - qt_init_start);
+#endif
+}
+
+int CLazy_DB_Access::Run(const std::function<int()>& console) {
+#ifdef DDO_NOT_USE_QT
+	return console();	//no application to create, so no need for another thread
+#else
+	int result = __LINE__;
+	{
+		std::lock_guard<std::mutex> lock{ mGuard };
+		mRunning = true;
+	}
+
+	std::thread console_thread{ [&]() {
+		result = console();
+
+		std::lock_guard<std::mutex> lock{ mGuard };
+		mRunning = false;
+		mSignal.notify_all();
+	} };
+
+	{
+		std::unique_lock<std::mutex> lock{ mGuard };
+		while (true) {
+			mSignal.wait(lock, [this]() { return !mRunning || mRequested; });
+			if (mRequested) {
+				Create_Application();
+				mRequested = false;
+				mSignal.notify_all();
+			}
+
+			if (!mRunning)
+				break;
+		}
+	}
+
+	console_thread.join();
+	return result;
+#endif
+}
+
+void CLazy_DB_Access::Initialize() {
+#ifndef DDO_NOT_USE_QT
+	{
+		std::lock_guard<std::mutex> lock{ DB_Access_Guard };
+		if (DB_Application)
+			return;
+	}
+
+	std::unique_lock<std::mutex> lock{ mGuard };
+	if (!mRunning || (std::this_thread::get_id() == mMain_Thread)) {
+		Create_Application();	//nobody else would serve the request
+		return;
+	}
+
+	//the concurrent requests wait for the same application
+	mRequested = true;
+	mSignal.notify_all();
+	mSignal.wait(lock, [this]() { return !mRequested; });
+#endif
+}
+
+HRESULT IfaceCalling Setup_Lazy_DB_Access(scgms::IFilter* filter, const void* data) {
+	db::IDb_Sink* db_sink = nullptr;
+	if (!Succeeded(filter->QueryInterface(&db::IID_Db_Sink, reinterpret_cast<void**>(&db_sink))) || !db_sink)
+		return S_OK;	//most filters do not need any database
+	db_sink->Release();
+
+#ifndef DDO_NOT_USE_QT
+	CLazy_DB_Access* db_access = Active_DB_Access;
+	if (db_access)
+		db_access->Initialize();
+
+	return Setup_Filter_DB_Access(filter, data);
+#else
+	static std::atomic<bool> warned{ false };
+	if (!warned.exchange(true))
+		std::wcerr << L"Warning! A filter requests database access, but this console was built without Qt." << std::endl;
+
+	return S_OK;
+#endif
+}
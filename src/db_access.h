@@ -0,0 +1,72 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/FilterLib.h>
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// database access, and the Qt application it needs, come to life only once a filter actually asks for a database connector,
+// so that the runs without a database pay neither the Qt initialization, nor its memory;
+// Qt requires the application on the main thread, while the filters are created on any thread, e.g.; a batch worker,
+// so the console runs on its own thread, and the main thread waits to create the application on request
+class CLazy_DB_Access {
+protected:
+	int& mArgc;
+	char** mArgv;
+	const std::thread::id mMain_Thread = std::this_thread::get_id();
+
+	std::mutex mGuard;
+	std::condition_variable mSignal;
+	bool mRunning = false;
+	bool mRequested = false;
+
+	void Create_Application();
+public:
+	CLazy_DB_Access(int& argc, char** argv);	//must be constructed on the main thread, the arguments go to the Qt application
+	~CLazy_DB_Access();							//shuts the Qt application down, if it was ever created
+
+	int Run(const std::function<int()>& console);	//runs the console, while the main thread serves the requests to create the application
+	void Initialize();							//creates the application on the main thread, and waits for it
+};
+
+HRESULT IfaceCalling Setup_Lazy_DB_Access(scgms::IFilter* filter, const void* data);
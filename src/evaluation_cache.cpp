@@ -0,0 +1,284 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "evaluation_cache.h"
+#include "event_log.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <fstream>
+#include <iostream>
+
+constexpr uint64_t FNV_Offset_Basis = 14695981039346656037ULL;
+constexpr uint64_t FNV_Prime = 1099511628211ULL;
+
+uint64_t FNV_1a(const void* data, const size_t size, uint64_t hash = FNV_Offset_Basis) {
+	const auto bytes = reinterpret_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_Prime;
+	}
+
+	return hash;
+}
+
+struct TEvaluation_Cache_Header {
+	char magic[8] = { 'S', 'C', 'G', 'M', 'S', 'E', 'C', 0 };
+	uint32_t version = 1;
+	uint32_t reserved = 0;
+	uint64_t configuration_hash = 0;
+	uint64_t problem_size = 0;
+	uint64_t metrics_count = 0;
+	uint64_t count = 0;
+};
+
+size_t CEvaluation_Cache::TParameters_Hash::operator()(const std::vector<double>& parameters) const {
+	return static_cast<size_t>(FNV_1a(parameters.data(), parameters.size() * sizeof(double)));
+}
+
+CEvaluation_Cache::CEvaluation_Cache(const uint64_t configuration_hash, const size_t problem_size, const size_t metrics_count)
+	: mConfiguration_Hash(configuration_hash), mProblem_Size(problem_size), mMetrics_Count(metrics_count) {
+}
+
+std::vector<double> CEvaluation_Cache::Make_Key(const double* parameters) const {
+	std::vector<double> key{ parameters, parameters + mProblem_Size };
+	for (auto& value : key)
+		if (value == 0.0)
+			value = 0.0;	//-0.0 evaluates the same as 0.0, but differs in bits
+
+	return key;
+}
+
+bool CEvaluation_Cache::Find(const double* parameters, std::vector<double>& metrics) {
+	const auto key = Make_Key(parameters);
+
+	{
+		std::lock_guard<std::mutex> lock{ mGuard };
+		const auto entry = mEntries.find(key);
+		if (entry != mEntries.end()) {
+			metrics = entry->second;
+			mHits++;
+			return true;
+		}
+	}
+
+	mMisses++;
+	return false;
+}
+
+void CEvaluation_Cache::Store(const double* parameters, const std::vector<double>& metrics) {
+	if (metrics.size() != mMetrics_Count)
+		return;
+
+	auto key = Make_Key(parameters);
+
+	std::lock_guard<std::mutex> lock{ mGuard };
+	mEntries.emplace(std::move(key), metrics);
+}
+
+size_t CEvaluation_Cache::size() const {
+	std::lock_guard<std::mutex> lock{ mGuard };
+	return mEntries.size();
+}
+
+bool CEvaluation_Cache::Load(const std::wstring& path) {
+	std::ifstream cache_file{ filesystem::path{ path }, std::ios::binary };
+	if (!cache_file)
+		return false;
+
+	const TEvaluation_Cache_Header expected;
+	TEvaluation_Cache_Header header;
+	if (!cache_file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+
+	const bool matches = (memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0) && (header.version == expected.version)
+		&& (header.configuration_hash == mConfiguration_Hash) && (header.problem_size == mProblem_Size) && (header.metrics_count == mMetrics_Count);
+	if (!matches) {
+		std::wcout << L"The evaluation cache " << path << L" belongs to another configuration, starting anew." << std::endl;
+		return false;
+	}
+
+	std::vector<double> parameters(mProblem_Size), metrics(mMetrics_Count);
+	std::lock_guard<std::mutex> lock{ mGuard };
+	for (uint64_t i = 0; i < header.count; i++) {
+		if (!cache_file.read(reinterpret_cast<char*>(parameters.data()), parameters.size() * sizeof(double))
+			|| !cache_file.read(reinterpret_cast<char*>(metrics.data()), metrics.size() * sizeof(double))) {
+			std::wcerr << L"The evaluation cache " << path << L" is truncated!" << std::endl;
+			return false;
+		}
+
+		mEntries.emplace(parameters, metrics);
+	}
+
+	return true;
+}
+
+bool CEvaluation_Cache::Save(const std::wstring& path) const {
+	const filesystem::path final_path{ path };
+	filesystem::path temporary_path{ final_path };
+	temporary_path += L".tmp";
+
+	{
+		std::ofstream cache_file{ temporary_path, std::ios::binary | std::ios::trunc };
+
+		std::lock_guard<std::mutex> lock{ mGuard };
+
+		TEvaluation_Cache_Header header;
+		header.configuration_hash = mConfiguration_Hash;
+		header.problem_size = mProblem_Size;
+		header.metrics_count = mMetrics_Count;
+		header.count = mEntries.size();
+
+		cache_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (const auto& [parameters, metrics] : mEntries) {
+			cache_file.write(reinterpret_cast<const char*>(parameters.data()), parameters.size() * sizeof(double));
+			cache_file.write(reinterpret_cast<const char*>(metrics.data()), metrics.size() * sizeof(double));
+		}
+
+		if (!cache_file) {
+			std::wcerr << L"Cannot write the evaluation cache " << temporary_path.wstring() << std::endl;
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	filesystem::rename(temporary_path, final_path, ec);
+	if (ec) {
+		std::wcerr << L"Cannot replace the evaluation cache " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+//the stamp of a file, which a variable or a dataset may name, so that its new version does not reuse stale metrics
+uint64_t Hash_File_Stamp(const std::wstring& path, uint64_t hash) {
+	std::error_code ec;
+	const filesystem::path file_path{ path };
+	if (path.empty() || !filesystem::is_regular_file(file_path, ec))
+		return hash;
+
+	const uint64_t size = static_cast<uint64_t>(filesystem::file_size(file_path, ec));
+	const int64_t mtime = static_cast<int64_t>(filesystem::last_write_time(file_path, ec).time_since_epoch().count());
+	hash = FNV_1a(&size, sizeof(size), hash);
+	return FNV_1a(&mtime, sizeof(mtime), hash);
+}
+
+//the configuration text without the values of the optimized parameters, which every save of the optimized parameters rewrites
+uint64_t Hash_Masked_Image(const TConfiguration_Image& image, const TAction& action) {
+	auto trim = [](const std::string& str) {
+		const auto first = str.find_first_not_of(" \t\r");
+		return first == std::string::npos ? std::string{} : str.substr(first, str.find_last_not_of(" \t\r") - first + 1);
+	};
+
+	auto equal_names = [](const std::string& key, const std::wstring& name) {
+		//the configuration keys are case-insensitive
+		return (key.size() == name.size()) && std::equal(key.begin(), key.end(), name.begin(), [](const char a, const wchar_t b) {
+			return std::towlower(static_cast<wchar_t>(static_cast<unsigned char>(a))) == std::towlower(b);
+		});
+	};
+
+	uint64_t hash = FNV_Offset_Basis;
+	size_t filter_count = 0;		//the filters are the sections in the order of the file
+	size_t line_begin = 0;
+	while (line_begin < image.content.size()) {
+		size_t line_end = image.content.find('\n', line_begin);
+		if (line_end == std::string::npos)
+			line_end = image.content.size();
+
+		const std::string line = trim(image.content.substr(line_begin, line_end - line_begin));
+		line_begin = line_end + 1;
+
+		if (line.empty())
+			continue;
+
+		if (line.front() == '[')
+			filter_count++;
+		else {
+			const auto delimiter_pos = line.find('=');
+			if (delimiter_pos != std::string::npos) {
+				const std::string key = trim(line.substr(0, delimiter_pos));
+				const bool optimized = std::any_of(action.parameters_to_optimize.begin(), action.parameters_to_optimize.end(), [&](const TOptimize_Parameter& parameter) {
+					return (filter_count > 0) && (parameter.index == filter_count - 1) && equal_names(key, parameter.name);
+				});
+
+				if (optimized)
+					continue;	//the evaluated solutions replace the values, while the bounds do not affect the metrics
+			}
+		}
+
+		hash = FNV_1a(line.data(), line.size(), hash);
+		hash = FNV_1a("\n", 1, hash);
+	}
+
+	return hash;
+}
+
+uint64_t Hash_Configuration(const TConfiguration_Image& image, const TAction& action) {
+	uint64_t hash = Hash_Masked_Image(image, action);
+
+	for (const auto& variable : action.variables) {
+		hash = FNV_1a(variable.name.data(), variable.name.size() * sizeof(wchar_t), hash);
+		hash = FNV_1a(L"=", sizeof(wchar_t), hash);
+		hash = FNV_1a(variable.value.data(), variable.value.size() * sizeof(wchar_t), hash);
+		hash = Hash_File_Stamp(variable.value, hash);
+	}
+
+	hash = FNV_1a(action.dataset_variable.data(), action.dataset_variable.size() * sizeof(wchar_t), hash);
+	for (const auto& dataset : action.datasets) {
+		hash = FNV_1a(dataset.data(), dataset.size() * sizeof(wchar_t), hash);
+		hash = Hash_File_Stamp(dataset, hash);
+	}
+	hash = FNV_1a(&action.aggregation, sizeof(action.aggregation), hash);
+	hash = FNV_1a(&action.aggregation_percentile, sizeof(action.aggregation_percentile), hash);
+
+	//a re-converted event log changes the metrics, while its path stays the same
+	hash = FNV_1a(action.event_log_path.data(), action.event_log_path.size() * sizeof(wchar_t), hash);
+	if (!action.event_log_path.empty()) {
+		for (size_t i = 0; i < std::max(action.datasets.size(), static_cast<size_t>(1)); i++)
+			hash = Hash_File_Stamp(Dataset_Event_Log_Path(action, i), hash);
+	}
+
+	for (const auto& parameter : action.parameters_to_optimize) {
+		hash = FNV_1a(&parameter.index, sizeof(parameter.index), hash);
+		hash = FNV_1a(parameter.name.data(), parameter.name.size() * sizeof(wchar_t), hash);
+	}
+
+	return hash;
+}
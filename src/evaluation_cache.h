@@ -0,0 +1,82 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include "options.h"
+#include "utils.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// remembers the metrics of already evaluated parameter vectors of a single configuration;
+// bit-identical vectors hit, and the whole cache can be persisted across runs
+class CEvaluation_Cache {
+protected:
+	struct TParameters_Hash {
+		size_t operator()(const std::vector<double>& parameters) const;
+	};
+
+	const uint64_t mConfiguration_Hash;
+	const size_t mProblem_Size, mMetrics_Count;
+
+	mutable std::mutex mGuard;
+	std::unordered_map<std::vector<double>, std::vector<double>, TParameters_Hash> mEntries;
+	std::atomic<size_t> mHits{ 0 }, mMisses{ 0 };
+
+	std::vector<double> Make_Key(const double* parameters) const;
+public:
+	CEvaluation_Cache(const uint64_t configuration_hash, const size_t problem_size, const size_t metrics_count);
+
+	bool Find(const double* parameters, std::vector<double>& metrics);	//counts a hit, or a miss
+	void Store(const double* parameters, const std::vector<double>& metrics);
+
+	//a missing file, or a file of another configuration, leaves the cache as it is
+	bool Load(const std::wstring& path);
+	bool Save(const std::wstring& path) const;
+
+	size_t hits() const { return mHits; }
+	size_t misses() const { return mMisses; }
+	size_t size() const;
+};
+
+//identifies the configuration file contents but the values of the optimized parameters, the variables, the datasets, the replayed event logs
+//and the parameters to optimize; the files named by the variables, datasets and event logs count by their size and modification time
+uint64_t Hash_Configuration(const TConfiguration_Image& image, const TAction& action);
@@ -0,0 +1,530 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "event_log.h"
+
+#include <scgms/utils/string_utils.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+std::mutex Event_Log_Cache_Guard;
+std::map<std::wstring, std::weak_ptr<const CEvent_Log>> Event_Log_Cache;	//by the absolute path
+
+bool Has_Event_Payload(const uint8_t event_code) {
+	switch (static_cast<scgms::NDevice_Event_Code>(event_code)) {
+		case scgms::NDevice_Event_Code::Parameters:
+		case scgms::NDevice_Event_Code::Parameters_Hint:
+		case scgms::NDevice_Event_Code::Information:
+		case scgms::NDevice_Event_Code::Warning:
+		case scgms::NDevice_Event_Code::Error:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+bool Is_Loggable_Event_Code(const uint8_t event_code) {
+	if (Is_Streamable_Event_Code(event_code) || Has_Event_Payload(event_code))
+		return true;
+
+	//the replay shuts the chain down on its own, once it runs out of the events
+	switch (static_cast<scgms::NDevice_Event_Code>(event_code)) {
+		case scgms::NDevice_Event_Code::Warm_Reset:
+		case scgms::NDevice_Event_Code::Solve_Parameters:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+// event, whose payload follows it when the events get sorted into the segments
+struct TConverted_Event {
+	TEvent_Record record;
+	std::string payload;
+};
+
+/*
+ * SmartCGMS log, i.e.; the output of the log filter, which the log replay filter reads:
+ *   header line, starting with Logical Clock
+ *   one event per line, fields separated by semicolons:
+ *     Logical Clock; Device Time; Event Code; Signal; Info; Segment Id; Event Code Id; Device Id; Signal Id;
+ *   Info is the level, the parameters separated by spaces, or the text of information, warning or error
+ */
+const char Log_Header_Prefix[] = "Logical Clock";
+
+enum class NLog_Column : size_t {
+	logical_clock = 0,
+	device_time,
+	event_code,
+	signal,
+	info,
+	segment_id,
+	event_code_id,
+	device_id,
+	signal_id,
+
+	count
+};
+
+std::string_view Trim_Field(const char* begin, const char* end) {
+	while ((begin < end) && ((*begin == ' ') || (*begin == '\t')))
+		begin++;
+	while ((end > begin) && ((end[-1] == ' ') || (end[-1] == '\t') || (end[-1] == '\r')))
+		end--;
+
+	return std::string_view{ begin, static_cast<size_t>(end - begin) };
+}
+
+//the log writes the device time as the local time, which the log replay converts back the same way
+bool Parse_Log_Device_Time(const std::string_view& field, double& device_time) {
+	std::string time_str{ field };
+
+	//fractions of the second, if any, follow the last colon
+	double fraction = 0.0;
+	const size_t colon_pos = time_str.rfind(':');
+	const size_t fraction_pos = colon_pos != std::string::npos ? time_str.find('.', colon_pos) : std::string::npos;
+	if (fraction_pos != std::string::npos) {
+		if (!Parse_Double(std::string_view{ time_str }.substr(fraction_pos), fraction))
+			return false;
+		time_str.resize(fraction_pos);
+	}
+
+	for (const char* format : { "%d.%m.%Y %H:%M:%S", "%Y-%m-%d %H:%M:%S" }) {
+		std::tm local_time{};
+		std::istringstream time_stream{ time_str };
+		time_stream >> std::get_time(&local_time, format);
+		if (time_stream.fail() || (time_stream.peek() != std::char_traits<char>::eof()))
+			continue;
+
+		local_time.tm_isdst = -1;
+		const std::time_t unix_time = std::mktime(&local_time);
+		if (unix_time == static_cast<std::time_t>(-1))
+			return false;
+
+		constexpr double Seconds_Per_Day = 24.0 * 60.0 * 60.0;
+		constexpr double Unix_Epoch_Rat_Time = 25569.0;	//1970-01-01 in days since 1899-12-30
+		device_time = (static_cast<double>(unix_time) + fraction) / Seconds_Per_Day + Unix_Epoch_Rat_Time;
+		return true;
+	}
+
+	return false;
+}
+
+//returns false for a malformed line, and sets is_event to false for a line without an event
+bool Parse_Log_Line(const char* begin, const char* end, TConverted_Event& event, bool& is_event) {
+	is_event = false;
+
+	std::array<std::string_view, static_cast<size_t>(NLog_Column::count)> fields;
+	size_t field_count = 0;
+	const char* field_begin = begin;
+	for (const char* pos = begin; (pos <= end) && (field_count < fields.size()); pos++) {
+		if ((pos == end) || (*pos == ';')) {
+			fields[field_count++] = Trim_Field(field_begin, pos);
+			field_begin = pos + 1;
+		}
+	}
+
+	if ((field_count == 1) && fields[0].empty())
+		return true;	//nothing to parse
+	if (field_count < fields.size())
+		return false;
+
+	auto field = [&fields](const NLog_Column column) { return fields[static_cast<size_t>(column)]; };
+
+	uint64_t event_code = 0;
+	if (!Parse_Uint(field(NLog_Column::event_code_id), event_code) || (event_code > std::numeric_limits<uint8_t>::max()))
+		return false;
+	if (event_code == static_cast<uint64_t>(scgms::NDevice_Event_Code::Shut_Down))
+		return true;	//the replay shuts the chain down on its own
+	if (!Is_Loggable_Event_Code(static_cast<uint8_t>(event_code)))
+		return false;
+
+	event = TConverted_Event{};
+	TEvent_Record& record = event.record;
+	record.event_code = static_cast<uint8_t>(event_code);
+	if (!Parse_Uint(field(NLog_Column::segment_id), record.segment_id) || !Parse_Log_Device_Time(field(NLog_Column::device_time), record.device_time))
+		return false;
+
+	if (!field(NLog_Column::signal_id).empty()) {
+		bool ok = false;
+		record.signal_id = WString_To_GUID(Widen_Char(std::string{ field(NLog_Column::signal_id) }.c_str()), ok);
+		if (!ok)
+			return false;
+	}
+
+	switch (static_cast<scgms::NDevice_Event_Code>(event_code)) {
+		case scgms::NDevice_Event_Code::Level:
+		case scgms::NDevice_Event_Code::Masked_Level:
+			if (!Parse_Double(field(NLog_Column::info), record.level))
+				return false;
+			break;
+
+		case scgms::NDevice_Event_Code::Parameters:
+		case scgms::NDevice_Event_Code::Parameters_Hint:
+		{
+			bool ok = false;
+			const std::vector<double> parameters = str_2_dbls(Widen_Char(std::string{ field(NLog_Column::info) }.c_str()).c_str(), ok);
+			if (!ok)
+				return false;
+			event.payload.assign(reinterpret_cast<const char*>(parameters.data()), parameters.size() * sizeof(double));
+			break;
+		}
+
+		case scgms::NDevice_Event_Code::Information:
+		case scgms::NDevice_Event_Code::Warning:
+		case scgms::NDevice_Event_Code::Error:
+			event.payload = std::string{ field(NLog_Column::info) };
+			break;
+
+		default:
+			break;
+	}
+
+	is_event = true;
+	return true;
+}
+
+int Convert_Event_Log(const TAction& action) {
+	if (action.event_log_path.empty()) {
+		std::wcerr << L"Conversion requires the --event_log file to write!" << std::endl;
+		return __LINE__;
+	}
+
+	const CMapped_File source{ filesystem::path{ action.config_path } };
+	if (!source.is_open()) {
+		std::wcerr << L"Cannot open the events " << action.config_path << std::endl;
+		return __LINE__;
+	}
+
+	std::vector<TConverted_Event> events;
+	size_t malformed_count = 0;
+
+	TEvent_Stream_Header stream_header;
+	stream_header.version = 0;	//no header, unless read below
+	if (source.size() >= sizeof(stream_header))
+		memcpy(&stream_header, source.data(), sizeof(stream_header));
+
+	if (Is_Event_Stream_Header(stream_header)) {
+		const size_t record_count = (source.size() - sizeof(stream_header)) / sizeof(TEvent_Record);
+		const char* record_data = source.data() + sizeof(stream_header);
+		for (size_t i = 0; i < record_count; i++) {
+			TConverted_Event event;
+			memcpy(&event.record, record_data + i * sizeof(TEvent_Record), sizeof(TEvent_Record));
+			if (Is_Streamable_Event_Code(event.record.event_code))
+				events.push_back(std::move(event));
+			else
+				malformed_count++;
+		}
+	}
+	else {
+		const char* data_begin = source.data();
+		const char* data_end = source.data() + source.size();
+
+		//the log filter may have started its output with the byte order mark of UTF-8
+		const char utf8_bom[] = "\xEF\xBB\xBF";
+		if ((data_end - data_begin >= 3) && (memcmp(data_begin, utf8_bom, 3) == 0))
+			data_begin += 3;
+
+		const size_t log_header_length = sizeof(Log_Header_Prefix) - 1;
+		const bool smartcgms_log = (static_cast<size_t>(data_end - data_begin) >= log_header_length) && (memcmp(data_begin, Log_Header_Prefix, log_header_length) == 0);
+		if (smartcgms_log) {
+			const char* header_end = static_cast<const char*>(memchr(data_begin, '\n', data_end - data_begin));
+			data_begin = header_end ? header_end + 1 : data_end;
+		}
+
+		CEvent_Line_Parser line_parser;
+		for (const char* line_begin = data_begin; line_begin < data_end; ) {
+			const char* line_end = static_cast<const char*>(memchr(line_begin, '\n', data_end - line_begin));
+			if (!line_end)
+				line_end = data_end;
+
+			TConverted_Event event;
+			bool is_event = false;
+			const bool parsed = smartcgms_log ? Parse_Log_Line(line_begin, line_end, event, is_event) : line_parser.Parse(line_begin, line_end, event.record, is_event);
+			if (!parsed)
+				malformed_count++;
+			else if (is_event)
+				events.push_back(std::move(event));
+
+			line_begin = line_end + 1;
+		}
+	}
+
+	//each segment becomes a contiguous run, so that the index can address it
+	std::stable_sort(events.begin(), events.end(), [](const TConverted_Event& a, const TConverted_Event& b) { return a.record.segment_id < b.record.segment_id; });
+
+	std::vector<TEvent_Record> records;
+	std::vector<TEvent_Log_Segment> segments;
+	std::vector<TEvent_Log_Payload> payloads;
+	std::string payload_data;
+	records.reserve(events.size());
+	for (size_t i = 0; i < events.size(); i++) {
+		const TEvent_Record& record = events[i].record;
+		records.push_back(record);
+
+		if (segments.empty() || (segments.back().segment_id != record.segment_id))
+			segments.push_back(TEvent_Log_Segment{ record.segment_id, i, 0 });
+		segments.back().record_count++;
+
+		if (Has_Event_Payload(record.event_code)) {
+			payloads.push_back(TEvent_Log_Payload{ i, payload_data.size(), events[i].payload.size() });
+			payload_data += events[i].payload;
+		}
+	}
+
+	TEvent_Log_Header header;
+	header.record_count = records.size();
+	header.segment_count = segments.size();
+	header.index_offset = sizeof(header) + records.size() * sizeof(TEvent_Record);
+	header.payload_count = payloads.size();
+	header.payload_offset = header.index_offset + segments.size() * sizeof(TEvent_Log_Segment);
+	header.payload_data_size = payload_data.size();
+
+	const filesystem::path final_path{ action.event_log_path };
+	filesystem::path temporary_path{ final_path };
+	temporary_path += L".tmp";
+
+	{
+		std::ofstream log_file{ temporary_path, std::ios::binary | std::ios::trunc };
+		log_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		log_file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(TEvent_Record));
+		log_file.write(reinterpret_cast<const char*>(segments.data()), segments.size() * sizeof(TEvent_Log_Segment));
+		log_file.write(reinterpret_cast<const char*>(payloads.data()), payloads.size() * sizeof(TEvent_Log_Payload));
+		log_file.write(payload_data.data(), payload_data.size());
+
+		if (!log_file) {
+			std::wcerr << L"Cannot write the event log " << temporary_path.wstring() << std::endl;
+			return __LINE__;
+		}
+	}
+
+	std::error_code ec;
+	filesystem::rename(temporary_path, final_path, ec);
+	if (ec) {
+		std::wcerr << L"Cannot replace the event log " << action.event_log_path << std::endl;
+		return __LINE__;
+	}
+
+	std::wcout << L"Converted " << records.size() << L" events of " << segments.size() << L" segments to " << action.event_log_path << L'.' << std::endl;
+	if (malformed_count > 0)
+		std::wcerr << L"Warning: " << malformed_count << L" malformed events were skipped!" << std::endl;
+
+	return 0;
+}
+
+CEvent_Log::CEvent_Log(const std::wstring& path) : mFile(filesystem::path{ path }, false) {
+	if (!mFile.is_open()) {
+		std::wcerr << L"Cannot open the event log " << path << std::endl;
+		return;
+	}
+
+	const TEvent_Log_Header expected;
+	TEvent_Log_Header header;
+	if (mFile.size() >= sizeof(header))
+		memcpy(&header, mFile.data(), sizeof(header));
+
+	//the counts are bounded by the file size first, so that the products below cannot overflow
+	bool valid = (mFile.size() >= sizeof(header)) && (memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0)
+		&& (header.version == expected.version) && (header.record_size == sizeof(TEvent_Record))
+		&& (header.record_count <= mFile.size() / sizeof(TEvent_Record)) && (header.segment_count <= mFile.size() / sizeof(TEvent_Log_Segment))
+		&& (header.index_offset == sizeof(header) + header.record_count * sizeof(TEvent_Record))
+		&& (header.index_offset + header.segment_count * sizeof(TEvent_Log_Segment) <= mFile.size())
+		&& (header.payload_count <= mFile.size() / sizeof(TEvent_Log_Payload)) && (header.payload_data_size <= mFile.size())
+		&& (header.payload_offset == header.index_offset + header.segment_count * sizeof(TEvent_Log_Segment))
+		&& (header.payload_offset + header.payload_count * sizeof(TEvent_Log_Payload) + header.payload_data_size == mFile.size());
+
+	//the replay reads the records of each segment without any bounds checks, so the segments must stay within the records, and must not overlap
+	const TEvent_Log_Segment* segments = valid ? reinterpret_cast<const TEvent_Log_Segment*>(mFile.data() + header.index_offset) : nullptr;
+	uint64_t previous_end = 0;
+	for (uint64_t i = 0; valid && (i < header.segment_count); i++) {
+		const TEvent_Log_Segment& segment = segments[i];
+		valid = (segment.first_record >= previous_end) && (segment.first_record <= header.record_count)
+			&& (segment.record_count <= header.record_count - segment.first_record);
+		previous_end = segment.first_record + segment.record_count;
+	}
+
+	//corrupted event codes must not reach the chain, and each record with a payload must have exactly one within the payload data
+	const TEvent_Record* records = valid ? reinterpret_cast<const TEvent_Record*>(mFile.data() + sizeof(header)) : nullptr;
+	uint64_t payload_record_count = 0;
+	for (uint64_t i = 0; valid && (i < header.record_count); i++) {
+		valid = Is_Loggable_Event_Code(records[i].event_code);
+		if (Has_Event_Payload(records[i].event_code))
+			payload_record_count++;
+	}
+
+	const TEvent_Log_Payload* payloads = valid ? reinterpret_cast<const TEvent_Log_Payload*>(mFile.data() + header.payload_offset) : nullptr;
+	valid &= (payload_record_count == header.payload_count);
+	for (uint64_t i = 0; valid && (i < header.payload_count); i++) {
+		const TEvent_Log_Payload& payload = payloads[i];
+		valid = ((i == 0) || (payload.record_index > payloads[i - 1].record_index)) && (payload.record_index < header.record_count)
+			&& Has_Event_Payload(records[payload.record_index].event_code)
+			&& (payload.offset <= header.payload_data_size) && (payload.size <= header.payload_data_size - payload.offset);
+
+		const auto event_code = static_cast<scgms::NDevice_Event_Code>(valid ? records[payload.record_index].event_code : 0);
+		if ((event_code == scgms::NDevice_Event_Code::Parameters) || (event_code == scgms::NDevice_Event_Code::Parameters_Hint))
+			valid = (payload.size % sizeof(double) == 0);
+	}
+
+	if (!valid) {
+		std::wcerr << L"The event log " << path << L" is not valid, convert the events with --convert first!" << std::endl;
+		return;
+	}
+
+	//the header keeps the records and the index 8-byte aligned within the page-aligned map
+	mRecord_Count = static_cast<size_t>(header.record_count);
+	mSegment_Count = static_cast<size_t>(header.segment_count);
+	mPayload_Count = static_cast<size_t>(header.payload_count);
+	mSegments = segments;
+	mPayloads = payloads;
+	mPayload_Data = mFile.data() + header.payload_offset + header.payload_count * sizeof(TEvent_Log_Payload);
+	mRecords = records;
+}
+
+std::shared_ptr<const CEvent_Log> Acquire_Event_Log(const std::wstring& path) {
+	const std::wstring absolute_path = Make_Absolute_Path(path, filesystem::current_path()).wstring();
+
+	std::lock_guard<std::mutex> lock{ Event_Log_Cache_Guard };
+	auto& cached_log = Event_Log_Cache[absolute_path];
+	auto log = cached_log.lock();
+	if (!log) {
+		log = std::make_shared<const CEvent_Log>(absolute_path);
+		if (!log->is_valid())
+			return nullptr;
+
+		cached_log = log;
+	}
+
+	return log;
+}
+
+std::wstring Dataset_Event_Log_Path(const TAction& action, const size_t dataset_index) {
+	std::wstring path = action.event_log_path;
+	if (action.datasets.empty())
+		return path;
+
+	const std::wstring reference = L"$(" + action.dataset_variable + L")";
+	for (size_t pos = path.find(reference); pos != std::wstring::npos; pos = path.find(reference, pos + action.datasets[dataset_index].size()))
+		path.replace(pos, reference.size(), action.datasets[dataset_index]);
+
+	return path;
+}
+
+TEvent_Log_Cache_Stats Event_Log_Cache_Stats() {
+	TEvent_Log_Cache_Stats stats;
+
+	std::lock_guard<std::mutex> lock{ Event_Log_Cache_Guard };
+	for (const auto& [path, cached_log] : Event_Log_Cache) {
+		const auto log = cached_log.lock();
+		if (log) {
+			stats.log_count++;
+			stats.mapped_size += log->mapped_size();
+		}
+	}
+
+	return stats;
+}
+
+CEvent_Log_Feeder::~CEvent_Log_Feeder() {
+	Finish();
+}
+
+void CEvent_Log_Feeder::Start(scgms::SFilter_Executor executor) {
+	mExecutor = executor;
+	mInjector = std::thread{ &CEvent_Log_Feeder::Injector, this };
+}
+
+void CEvent_Log_Feeder::Finish() {
+	mStop = true;
+	if (mInjector.joinable())
+		mInjector.join();
+
+	mExecutor.reset();
+}
+
+void Set_Event_Payload(scgms::UDevice_Event& event, const uint8_t event_code, const char* data, const size_t size) {
+	const auto code = static_cast<scgms::NDevice_Event_Code>(event_code);
+	if ((code == scgms::NDevice_Event_Code::Parameters) || (code == scgms::NDevice_Event_Code::Parameters_Hint)) {
+		std::vector<double> parameters(size / sizeof(double));
+		memcpy(parameters.data(), data, parameters.size() * sizeof(double));	//the payload data is not aligned
+		event.parameters.set(parameters);
+	}
+	else
+		event.info.set(Widen_Char(std::string{ data, size }.c_str()).c_str());
+}
+
+void CEvent_Log_Feeder::Injector() {
+	const TEvent_Record* records = mLog->records();
+
+	//the segments follow each other in the records, so their payloads come in the order of the records too
+	size_t payload_index = 0;
+	for (size_t i = 0; i < mLog->segment_count(); i++) {
+		const TEvent_Log_Segment& segment = mLog->segment(i);
+		const size_t segment_end = static_cast<size_t>(segment.first_record + segment.record_count);
+		for (size_t record_index = static_cast<size_t>(segment.first_record); record_index != segment_end; record_index++) {
+			if (mStop)
+				return;
+
+			const TEvent_Record& record = records[record_index];
+			scgms::UDevice_Event event = Make_Device_Event(record);
+			if (event && Has_Event_Payload(record.event_code)) {
+				while (mLog->payload(payload_index).record_index < record_index)
+					payload_index++;
+
+				const TEvent_Log_Payload& payload = mLog->payload(payload_index);
+				Set_Event_Payload(event, record.event_code, mLog->payload_data(payload), static_cast<size_t>(payload.size));
+			}
+
+			if (!Succeeded(mExecutor.Execute(std::move(event))))
+				return;	//the chain has shut down on its own, or was cancelled
+		}
+	}
+
+	//the end of the log shuts the chain down, like the end of an input file does
+	mExecutor.Execute(scgms::UDevice_Event{ scgms::NDevice_Event_Code::Shut_Down });
+}
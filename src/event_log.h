@@ -0,0 +1,150 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include "execute.h"
+#include "event_stream.h"
+#include "mapped_file.h"
+#include "options.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+/*
+ * Event log, which the console replays from a memory map, without any parsing:
+ *   header: TEvent_Log_Header
+ *   records: TEvent_Record, each segment as a contiguous run, in the source order within the segment
+ *   index: TEvent_Log_Segment per segment, sorted by segment id, at header.index_offset
+ *   payloads: TEvent_Log_Payload per record of an event with a payload, sorted by the record, at header.payload_offset
+ *   payload data: header.payload_data_size bytes, right after the payloads
+ *
+ * parameters and parameters hints carry their doubles as the payload, while information, warning and error carry UTF-8 text
+ */
+
+struct TEvent_Log_Header {
+	char magic[8] = { 'S', 'C', 'G', 'M', 'S', 'E', 'B', 0 };
+	uint32_t version = 2;
+	uint32_t record_size = sizeof(TEvent_Record);
+	uint64_t record_count = 0;
+	uint64_t segment_count = 0;
+	uint64_t index_offset = 0;
+	uint64_t payload_count = 0;
+	uint64_t payload_offset = 0;
+	uint64_t payload_data_size = 0;
+};
+
+struct TEvent_Log_Segment {
+	uint64_t segment_id = 0;
+	uint64_t first_record = 0;
+	uint64_t record_count = 0;
+};
+
+struct TEvent_Log_Payload {
+	uint64_t record_index = 0;
+	uint64_t offset = 0;	//within the payload data
+	uint64_t size = 0;		//bytes
+};
+
+//the log carries the streamable events, the events with a payload, and the events without any data but their code
+bool Is_Loggable_Event_Code(const uint8_t event_code);
+bool Has_Event_Payload(const uint8_t event_code);
+
+//converts the events at action.config_path to the event log at action.event_log_path;
+//the events are either a SmartCGMS log, i.e.; the output of the log filter, or an event stream in either format
+int Convert_Event_Log(const TAction& action);
+
+// read-only view of an event log, shared by all the replays
+class CEvent_Log {
+protected:
+	CMapped_File mFile;
+	const TEvent_Record* mRecords = nullptr;
+	const TEvent_Log_Segment* mSegments = nullptr;
+	const TEvent_Log_Payload* mPayloads = nullptr;
+	const char* mPayload_Data = nullptr;
+	size_t mRecord_Count = 0, mSegment_Count = 0, mPayload_Count = 0;
+public:
+	CEvent_Log(const std::wstring& path);	//reports what is wrong with the file, if anything
+
+	bool is_valid() const { return mRecords != nullptr; }
+	size_t mapped_size() const { return mFile.size(); }
+	size_t record_count() const { return mRecord_Count; }
+	size_t segment_count() const { return mSegment_Count; }
+
+	const TEvent_Log_Segment& segment(const size_t index) const { return mSegments[index]; }
+	const TEvent_Record* records() const { return mRecords; }
+
+	//every record of an event with a payload has exactly one, so the records and their payloads can be walked together
+	size_t payload_count() const { return mPayload_Count; }
+	const TEvent_Log_Payload& payload(const size_t index) const { return mPayloads[index]; }
+	const char* payload_data(const TEvent_Log_Payload& payload) const { return mPayload_Data + payload.offset; }
+};
+
+//every event log is mapped once per process, and shared by all its replays for as long as any of them holds it;
+//returns nullptr for an invalid log
+std::shared_ptr<const CEvent_Log> Acquire_Event_Log(const std::wstring& path);
+
+//event log of the dataset, whose value substitutes the $(dataset_variable) reference in the event log path
+std::wstring Dataset_Event_Log_Path(const TAction& action, const size_t dataset_index);
+
+struct TEvent_Log_Cache_Stats {
+	size_t log_count = 0;
+	size_t mapped_size = 0;		//bytes
+};
+
+TEvent_Log_Cache_Stats Event_Log_Cache_Stats();	//of the logs currently held
+
+// feeds the executor with the events of a mapped event log, segment by segment
+// the log replaces the first filter of the chain, which must be its input, e.g.; the log replay, whose events were converted
+class CEvent_Log_Feeder : public CEvent_Feeder {
+protected:
+	const std::shared_ptr<const CEvent_Log> mLog;
+	scgms::SFilter_Executor mExecutor;
+	std::atomic<bool> mStop{ false };
+	std::thread mInjector;
+
+	void Injector();
+public:
+	CEvent_Log_Feeder(std::shared_ptr<const CEvent_Log> log) : mLog(std::move(log)) {}
+	virtual ~CEvent_Log_Feeder();
+
+	virtual void Start(scgms::SFilter_Executor executor) override final;
+	virtual void Finish() override final;
+	virtual bool Replaces_First_Filter() const override final { return true; }
+};
@@ -0,0 +1,152 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "event_stream.h"
+
+#include <scgms/utils/string_utils.h>
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+bool Is_Event_Stream_Header(const TEvent_Stream_Header& header) {
+	const TEvent_Stream_Header expected;
+	return (memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0) && (header.version == expected.version) && (header.record_size == sizeof(TEvent_Record));
+}
+
+bool Is_Streamable_Event_Code(const uint8_t event_code) {
+	switch (static_cast<scgms::NDevice_Event_Code>(event_code)) {
+		case scgms::NDevice_Event_Code::Level:
+		case scgms::NDevice_Event_Code::Masked_Level:
+		case scgms::NDevice_Event_Code::Time_Segment_Start:
+		case scgms::NDevice_Event_Code::Time_Segment_Stop:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+scgms::UDevice_Event Make_Device_Event(const TEvent_Record& record) {
+	scgms::UDevice_Event event{ static_cast<scgms::NDevice_Event_Code>(record.event_code) };
+	if (event) {
+		event.device_time() = record.device_time;
+		event.segment_id() = record.segment_id;
+		event.signal_id() = record.signal_id;	//e.g.; of the model, whose parameters an event carries
+		if ((record.event_code == static_cast<uint8_t>(scgms::NDevice_Event_Code::Level)) || (record.event_code == static_cast<uint8_t>(scgms::NDevice_Event_Code::Masked_Level)))
+			event.level() = record.level;
+	}
+
+	return event;
+}
+
+//strtod and strtoull need a terminated string, which a field of the read buffer is not
+template <typename T, typename F>
+bool Parse_Field(const std::string_view& field, T& value, F convert) {
+	char buffer[64];
+	if (field.size() >= sizeof(buffer))
+		return false;
+
+	memcpy(buffer, field.data(), field.size());
+	buffer[field.size()] = 0;
+
+	char* parsed_end = nullptr;
+	value = convert(buffer, &parsed_end);
+	return (parsed_end != buffer) && (*parsed_end == 0);
+}
+
+bool Parse_Double(const std::string_view& field, double& value) {
+	return Parse_Field(field, value, [](const char* str, char** str_end) { return std::strtod(str, str_end); });
+}
+
+bool Parse_Uint(const std::string_view& field, uint64_t& value) {
+	return Parse_Field(field, value, [](const char* str, char** str_end) { return static_cast<uint64_t>(std::strtoull(str, str_end, 10)); });
+}
+
+bool CEvent_Line_Parser::Parse(const char* begin, const char* end, TEvent_Record& record, bool& is_event) {
+	is_event = false;
+
+	//a comment may have any number of words, so it must not get split into the fields
+	const char* first_char = begin;
+	while ((first_char < end) && ((*first_char == ' ') || (*first_char == '\t') || (*first_char == ',') || (*first_char == '\r')))
+		first_char++;
+	if ((first_char == end) || (*first_char == '#'))
+		return true;	//nothing to parse
+
+	//no valid line has more than four fields
+	std::array<std::string_view, 5> fields;
+	size_t field_count = 0;
+	const char* field_begin = begin;
+	for (const char* pos = begin; pos <= end; pos++) {
+		if ((pos == end) || (*pos == ' ') || (*pos == '\t') || (*pos == ',') || (*pos == '\r')) {
+			if (pos > field_begin) {
+				if (field_count == fields.size())
+					return false;
+				fields[field_count++] = std::string_view{ field_begin, static_cast<size_t>(pos - field_begin) };
+			}
+			field_begin = pos + 1;
+		}
+	}
+
+	record = TEvent_Record{};
+
+	if ((fields[0] == "start") || (fields[0] == "stop")) {
+		record.event_code = static_cast<uint8_t>(fields[0] == "start" ? scgms::NDevice_Event_Code::Time_Segment_Start : scgms::NDevice_Event_Code::Time_Segment_Stop);
+		if ((field_count != 3) || !Parse_Uint(fields[1], record.segment_id) || !Parse_Double(fields[2], record.device_time))
+			return false;
+
+		is_event = true;
+		return true;
+	}
+
+	if ((field_count != 4) || !Parse_Uint(fields[0], record.segment_id) || !Parse_Double(fields[2], record.device_time) || !Parse_Double(fields[3], record.level))
+		return false;
+
+	if (fields[1] != mRecent_Signal_Str) {
+		bool ok = false;
+		const GUID signal_id = WString_To_GUID(Widen_Char(std::string{ fields[1] }.c_str()), ok);
+		if (!ok)
+			return false;
+
+		mRecent_Signal_Str = std::string{ fields[1] };
+		mRecent_Signal_Id = signal_id;
+	}
+
+	record.signal_id = mRecent_Signal_Id;
+	is_event = true;
+	return true;
+}
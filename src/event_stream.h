@@ -0,0 +1,96 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/FilterLib.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+ * Event stream formats, which the console reads from a pipe:
+ *
+ * line format, one event per line, fields separated by spaces, tabs or commas; empty lines and lines starting with # are skipped
+ *   segment_id signal_id device_time level		- level event, signal_id as {XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}
+ *   start segment_id device_time				- time segment start
+ *   stop segment_id device_time				- time segment stop
+ *
+ * binary format, which is recognized by its header
+ *   header: TEvent_Stream_Header
+ *   records: TEvent_Record until the end of the stream, in the native byte order
+ *
+ * device_time is the SmartCGMS rat time, i.e.; days since 1899-12-30 as a double
+ */
+
+struct TEvent_Stream_Header {
+	char magic[8] = { 'S', 'C', 'G', 'M', 'S', 'E', 'V', 0 };
+	uint32_t version = 1;
+	uint32_t record_size = 0;
+};
+
+struct TEvent_Record {
+	double device_time = 0.0;
+	double level = 0.0;
+	GUID signal_id = Invalid_GUID;
+	uint64_t segment_id = 0;
+	uint8_t event_code = static_cast<uint8_t>(scgms::NDevice_Event_Code::Level);
+	uint8_t reserved[7] = { 0 };
+};
+
+static_assert(sizeof(TEvent_Record) == 48, "TEvent_Record must keep its binary layout");
+
+bool Is_Event_Stream_Header(const TEvent_Stream_Header& header);
+
+//level events, and time segment starts and stops, are the only events the streams carry
+bool Is_Streamable_Event_Code(const uint8_t event_code);
+scgms::UDevice_Event Make_Device_Event(const TEvent_Record& record);
+
+//parse a single field of a line, which is not terminated
+bool Parse_Uint(const std::string_view& field, uint64_t& value);
+bool Parse_Double(const std::string_view& field, double& value);
+
+// parses the line format; consecutive events mostly share the signal, so the parser remembers the recent one
+class CEvent_Line_Parser {
+protected:
+	std::string mRecent_Signal_Str;
+	GUID mRecent_Signal_Id = Invalid_GUID;
+public:
+	//returns false for a malformed line, and sets is_event to false for a line without an event
+	bool Parse(const char* begin, const char* end, TEvent_Record& record, bool& is_event);
+};
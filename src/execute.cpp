@@ -0,0 +1,233 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "execute.h"
+
+#include "utils.h"
+#include "startup_timing.h"
+#include "db_access.h"
+#include "profiler.h"
+
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <deque>
+
+std::mutex Running_Executors_Guard;
+std::multimap<solver::TSolver_Progress*, scgms::SFilter_Executor> Running_Executors;
+
+void Shut_Down_Executor(scgms::SFilter_Executor& executor) {
+	scgms::UDevice_Event shut_down_event{ scgms::NDevice_Event_Code::Shut_Down };
+	executor.Execute(std::move(shut_down_event));
+}
+
+class CExecutor_Registration {
+protected:
+	solver::TSolver_Progress& mProgress;
+	scgms::SFilter_Executor mExecutor;
+public:
+	CExecutor_Registration(solver::TSolver_Progress& progress, scgms::SFilter_Executor& executor) : mProgress(progress), mExecutor(executor) {
+		std::lock_guard<std::mutex> lock{ Running_Executors_Guard };
+		Running_Executors.emplace(&mProgress, mExecutor);
+
+		//we could have been cancelled before the registration took place
+		if (mProgress.cancelled != FALSE)
+			Shut_Down_Executor(mExecutor);
+	}
+
+	~CExecutor_Registration() {
+		std::lock_guard<std::mutex> lock{ Running_Executors_Guard };
+		auto [begin, end] = Running_Executors.equal_range(&mProgress);
+		for (auto iter = begin; iter != end; iter++) {
+			if (iter->second.get() == mExecutor.get()) {
+				Running_Executors.erase(iter);
+				break;
+			}
+		}
+	}
+};
+
+void Cancel_Execution(solver::TSolver_Progress& progress) {
+	std::lock_guard<std::mutex> lock{ Running_Executors_Guard };
+
+	progress.cancelled = TRUE;
+
+	auto [begin, end] = Running_Executors.equal_range(&progress);
+	for (auto iter = begin; iter != end; iter++)
+		Shut_Down_Executor(iter->second);
+}
+
+void Cancel_All_Executions() {
+	std::lock_guard<std::mutex> lock{ Running_Executors_Guard };
+
+	for (auto& [progress, executor] : Running_Executors) {
+		progress->cancelled = TRUE;
+		Shut_Down_Executor(executor);
+	}
+}
+
+//shares the links of all the filters but the first one, so that the original chain stays whole, e.g.; to be saved
+scgms::SPersistent_Filter_Chain_Configuration Without_First_Filter(scgms::SPersistent_Filter_Chain_Configuration& configuration) {
+	scgms::SPersistent_Filter_Chain_Configuration result;
+
+	scgms::IFilter_Configuration_Link **begin = nullptr, **end = nullptr;
+	if (!result || (configuration->get(&begin, &end) != S_OK) || (end - begin < 2))
+		return {};
+
+	if (result->add(begin + 1, end) != S_OK)
+		return {};
+
+	return result;
+}
+
+HRESULT Run_Filters(scgms::SPersistent_Filter_Chain_Configuration& configuration, scgms::TOn_Filter_Created on_filter_created, const void* on_filter_created_data, solver::TSolver_Progress& progress, scgms::IFilter* output = nullptr, CEvent_Feeder* input = nullptr) {
+	//the feeder may take the place of the chain's input, which would otherwise emit its own events alongside the injected ones
+	scgms::SPersistent_Filter_Chain_Configuration executed_configuration = configuration;
+	if (input && input->Replaces_First_Filter()) {
+		executed_configuration = Without_First_Filter(configuration);
+		if (!executed_configuration) {
+			std::wcerr << L"The replayed events replace the first filter of the chain, which must be followed by at least one more filter!" << std::endl;
+			return E_FAIL;
+		}
+	}
+
+	refcnt::Swstr_list errors;
+	const auto construction_start = std::chrono::steady_clock::now();
+	scgms::SFilter_Executor executor{ executed_configuration.get(), on_filter_created, on_filter_created_data, errors, output };
+	Record_Startup_Phase(NStartup_Phase::executor_construction, std::chrono::steady_clock::now() - construction_start);
+	errors.for_each([](auto str) { std::wcerr << str << std::endl;	});
+
+	if (!executor) {
+		std::wcerr << L"Could not execute the filters!" << std::endl;
+		return E_FAIL;
+	}
+
+	// wait for filters to finish, or user to close the app
+	{
+		CExecutor_Registration registration{ progress, executor };
+		if (input)
+			input->Start(executor);
+
+		executor->Terminate(TRUE);
+
+		if (input)
+			input->Finish();
+	}
+
+	return progress.cancelled == FALSE ? S_OK : E_ABORT;
+}
+
+HRESULT IfaceCalling On_Filter_Created(scgms::IFilter* filter, const void* data) {
+	return Setup_Lazy_DB_Access(filter, data);
+}
+
+bool Is_Metric_Filter(scgms::IFilter* filter) {
+	scgms::ISignal_Error_Inspection* inspection = nullptr;
+	if (Succeeded(filter->QueryInterface(&scgms::IID_Signal_Error_Inspection, reinterpret_cast<void**>(&inspection))) && inspection) {
+		inspection->Release();
+		return true;
+	}
+
+	return false;
+}
+
+struct TMetric_Promises {
+	std::mutex guard;
+	std::deque<double> metrics;	//deque does not move the already promised values
+};
+
+HRESULT IfaceCalling On_Metric_Filter_Created(scgms::IFilter* filter, const void* data) {
+	auto promises = reinterpret_cast<TMetric_Promises*>(const_cast<void*>(data));
+
+	scgms::ISignal_Error_Inspection* inspection = nullptr;
+	if (Succeeded(filter->QueryInterface(&scgms::IID_Signal_Error_Inspection, reinterpret_cast<void**>(&inspection))) && inspection) {
+		double* metric = nullptr;
+		{
+			std::lock_guard<std::mutex> lock{ promises->guard };
+			promises->metrics.push_back(std::numeric_limits<double>::quiet_NaN());
+			metric = &promises->metrics.back();
+		}
+
+		//the metric gets written once the filter is destroyed
+		const HRESULT rc = inspection->Promise_Metric(scgms::All_Segments_Id, metric, TRUE);
+		inspection->Release();
+		if (!Succeeded(rc))
+			return rc;
+	}
+
+	return On_Filter_Created(filter, nullptr);
+}
+
+std::tuple<HRESULT, std::vector<double>> Evaluate_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, solver::TSolver_Progress& progress, CEvent_Feeder* input) {
+	TMetric_Promises promises;
+	const HRESULT rc = Run_Filters(configuration, On_Metric_Filter_Created, &promises, progress, nullptr, input);	//the executor and its filters are gone once we return
+
+	return { rc, std::vector<double>{ promises.metrics.begin(), promises.metrics.end() } };
+}
+
+HRESULT IfaceCalling CEvent_Counter::Execute(scgms::IDevice_Event* event) {
+	scgms::UDevice_Event discarded_event{ event };	//releases the event
+	mCount++;
+	return S_OK;
+}
+
+int Execute_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const bool save_config, solver::TSolver_Progress& progress, scgms::IFilter* output, CEvent_Feeder* input, CChain_Profiler* profiler) {
+	const HRESULT rc = profiler ? profiler->Run(configuration, progress, output) : Run_Filters(configuration, On_Filter_Created, nullptr, progress, output, input);
+	if (rc == E_FAIL)
+		return __LINE__;
+
+	if (rc == E_ABORT) {
+		if (save_config)
+			std::wcerr << L"The execution was cancelled, so the configuration is not saved." << std::endl;
+		return Cancelled_Exit_Code;
+	}
+
+	if (save_config) {
+		std::wcout << L"Saving configuration...";
+		refcnt::Swstr_list errors;
+		const HRESULT rc = configuration->Save_To_File(nullptr, errors.get());
+		errors.for_each([](auto str) { std::wcerr << str << std::endl; });
+		if (!Succeeded(rc)) {
+			std::wcerr << std::endl << L"Failed to save the configuration!" << std::endl;
+			std::wcerr << std::endl << L"Error 0x" << std::hex << rc << std::dec << ": "  << Describe_Error(rc) << std::endl;
+			return __LINE__;
+		}
+		else
+			std::wcout << L" saved." << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/FilterLib.h>
+#include <scgms/rtl/SolverLib.h>
+
+#include <scgms/rtl/referencedImpl.h>
+
+#include <atomic>
+#include <tuple>
+#include <vector>
+
+// injects events into a running executor from the outside of the chain, e.g.; from the standard input
+class CEvent_Feeder {
+public:
+	virtual ~CEvent_Feeder() = default;
+
+	virtual void Start(scgms::SFilter_Executor executor) = 0;	//must shut the executor down, once it runs out of events
+	virtual void Finish() = 0;									//the executor has terminated, so stop injecting
+	virtual bool Replaces_First_Filter() const { return false; }	//the chain runs without its first filter, whose events the feeder provides instead
+};
+
+class CChain_Profiler;
+
+constexpr int Cancelled_Exit_Code = 130;	//like a shell reports a process interrupted by SIGINT
+
+//executes the configuration, whose filters can be shut down by cancelling the given progress
+//events leaving the last filter go to the optional output, while the optional input injects events into the first one, or replaces it
+//the optional profiler builds and runs the chain on its own, so it does not take any input
+//a cancelled execution, e.g.; on a signal or a timeout, does not save the configuration, and returns Cancelled_Exit_Code
+int Execute_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const bool save_config, solver::TSolver_Progress& progress, scgms::IFilter* output = nullptr, CEvent_Feeder* input = nullptr, CChain_Profiler* profiler = nullptr);
+
+//executes the configuration and collects the metrics, which its metric filters have promised
+std::tuple<HRESULT, std::vector<double>> Evaluate_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, solver::TSolver_Progress& progress, CEvent_Feeder* input = nullptr);
+
+HRESULT IfaceCalling On_Filter_Created(scgms::IFilter* filter, const void* data);	//sets up the database access, if available
+bool Is_Metric_Filter(scgms::IFilter* filter);
+
+// terminal filter, which counts and discards the events leaving the chain
+class CEvent_Counter : public virtual scgms::IFilter, public virtual refcnt::CNotReferenced {
+protected:
+	std::atomic<size_t> mCount{ 0 };
+public:
+	virtual HRESULT IfaceCalling Configure(scgms::IFilter_Configuration* configuration, refcnt::wstr_list* error_description) override final { return S_OK; }
+	virtual HRESULT IfaceCalling Execute(scgms::IDevice_Event* event) override final;
+
+	size_t count() const { return mCount; }
+};
+
+void Cancel_Execution(solver::TSolver_Progress& progress);	//shuts down all executors run with the given progress
+void Cancel_All_Executions();								//shuts down all running executors
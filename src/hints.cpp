@@ -0,0 +1,586 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "hints.h"
+
+#include "utils.h"
+#include "mapped_file.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <unordered_set>
+
+constexpr size_t Hint_Chunk_Size = 4 * 1024 * 1024;	//larger files are parsed in chunks of roughly this size
+const wchar_t* Hint_Cache_Extension = L".hintcache";
+
+struct THint_Cache_Header {
+	char magic[8] = { 'S', 'C', 'G', 'M', 'S', 'H', 'C', 0 };
+	uint32_t version = 1;
+	uint32_t parameters_file_type = 0;
+	uint64_t source_size = 0;
+	int64_t source_mtime = 0;
+	uint64_t dimension = 0;
+	uint64_t count = 0;
+};
+
+struct THint_Chunk {
+	size_t file_index = 0;
+	const char* begin = nullptr, *end = nullptr;
+	std::vector<double> values;
+	size_t rejected_lines = 0;
+};
+
+struct THint_File {
+	filesystem::path path;
+	THint_Cache_Header stamp;		//identifies the source file version
+	bool cached = false;			//values were loaded from the cache
+	std::unique_ptr<CMapped_File> mapping;
+	std::vector<double> values;
+	size_t rejected_lines = 0;
+};
+
+THint_Cache_Header Stamp_Hint_File(const filesystem::path& path, const size_t expected_parameters_size, const bool parameters_file_type) {
+	THint_Cache_Header stamp;
+	std::error_code ec;
+
+	stamp.parameters_file_type = parameters_file_type ? 1 : 0;
+	stamp.source_size = static_cast<uint64_t>(filesystem::file_size(path, ec));
+	stamp.source_mtime = static_cast<int64_t>(filesystem::last_write_time(path, ec).time_since_epoch().count());
+	stamp.dimension = static_cast<uint64_t>(expected_parameters_size);
+
+	return stamp;
+}
+
+bool Read_Hint_Cache(THint_File& file) {
+	const filesystem::path cache_path{ file.path.wstring() + Hint_Cache_Extension };
+	std::ifstream cache{ cache_path, std::ios::binary };
+	if (!cache)
+		return false;
+
+	THint_Cache_Header header;
+	if (!cache.read(reinterpret_cast<char*>(&header), sizeof(header)))
+		return false;
+
+	const THint_Cache_Header& stamp = file.stamp;
+	const bool matches = (memcmp(header.magic, stamp.magic, sizeof(header.magic)) == 0) && (header.version == stamp.version)
+		&& (header.parameters_file_type == stamp.parameters_file_type) && (header.source_size == stamp.source_size)
+		&& (header.source_mtime == stamp.source_mtime) && (header.dimension == stamp.dimension);
+	if (!matches)
+		return false;
+
+	//do not trust the header to size the allocation, a truncated or foreign file must not pass
+	std::error_code ec;
+	const uint64_t cache_size = static_cast<uint64_t>(filesystem::file_size(cache_path, ec));
+	if (ec || (header.dimension == 0) || (header.count > (cache_size - sizeof(header)) / (header.dimension * sizeof(double)))
+		|| (sizeof(header) + header.count * header.dimension * sizeof(double) != cache_size))
+		return false;
+
+	file.values.resize(static_cast<size_t>(header.count * header.dimension));
+	return static_cast<bool>(cache.read(reinterpret_cast<char*>(file.values.data()), file.values.size() * sizeof(double)));
+}
+
+void Write_Hint_Cache(const THint_File& file) {
+	const filesystem::path cache_path{ file.path.wstring() + Hint_Cache_Extension };
+	//a concurrent run may read the cache meanwhile, so we write a unique temporary file and rename it over the cache at once;
+	//the temporary name keeps the cache extension, so that the hint enumeration skips it
+	const filesystem::path temporary_path{ file.path.wstring() + L"." + std::to_wstring(std::chrono::steady_clock::now().time_since_epoch().count()) + Hint_Cache_Extension };
+
+	THint_Cache_Header header = file.stamp;
+	header.count = header.dimension > 0 ? file.values.size() / header.dimension : 0;
+
+	bool written = false;
+	{
+		std::ofstream cache{ temporary_path, std::ios::binary | std::ios::trunc };
+		cache.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		cache.write(reinterpret_cast<const char*>(file.values.data()), header.count * header.dimension * sizeof(double));
+		cache.close();
+		written = static_cast<bool>(cache);
+	}
+
+	std::error_code ec;
+	if (written)
+		filesystem::rename(temporary_path, cache_path, ec);
+
+	if (!written || ec) {
+		filesystem::remove(temporary_path, ec);
+		std::wcerr << L"Cannot write the hint cache " << cache_path.wstring() << std::endl;
+	}
+}
+
+bool Is_Hint_Separator(const char ch) {
+	return (ch == ' ') || (ch == '\t') || (ch == ',') || (ch == ';') || (ch == '\r');
+}
+
+void Parse_Hint_Chunk(THint_Chunk& chunk, const size_t expected_parameters_size, const bool parameters_file_type) {
+	const size_t line_size = parameters_file_type ? 3 * expected_parameters_size : expected_parameters_size;
+	std::vector<double> line_values;
+	line_values.reserve(line_size);
+
+	const char* cursor = chunk.begin;
+	while (cursor < chunk.end) {
+		const char* line_end = reinterpret_cast<const char*>(memchr(cursor, '\n', static_cast<size_t>(chunk.end - cursor)));
+		if (!line_end)
+			line_end = chunk.end;
+
+		line_values.clear();
+		bool ok = true;
+		bool empty_line = true;
+		for (const char* pos = cursor; pos < line_end; ) {
+			if (Is_Hint_Separator(*pos)) {
+				pos++;
+				continue;
+			}
+
+			if ((*pos == '#') && empty_line)
+				break;	//comment line, such as the checkpoint header
+
+			empty_line = false;
+			if (*pos == '+')
+				pos++;
+
+			double value = 0.0;
+			const auto [parsed_end, ec] = std::from_chars(pos, line_end, value);
+			if ((ec != std::errc{}) || ((parsed_end < line_end) && !Is_Hint_Separator(*parsed_end))) {
+				ok = false;
+				break;
+			}
+
+			line_values.push_back(value);
+			pos = parsed_end;
+		}
+
+		if (!empty_line) {
+			ok &= line_values.size() == line_size;
+			if (ok) {
+				//loaded parameters also contain lower and upper bounds, which we need to strip off
+				const auto first = parameters_file_type ? line_values.begin() + expected_parameters_size : line_values.begin();
+				chunk.values.insert(chunk.values.end(), first, first + expected_parameters_size);
+			}
+			else
+				chunk.rejected_lines++;
+		}
+
+		cursor = line_end + 1;
+	}
+}
+
+std::vector<filesystem::path> Enumerate_Hint_Files(const std::vector<std::wstring>& hint_paths, bool& ok) {
+	std::vector<filesystem::path> result;
+	const auto current_dir = filesystem::current_path();
+	ok = true;
+
+	for (const auto& path_mask : hint_paths) {
+
+		const filesystem::path full_path{ Make_Absolute_Path(path_mask, current_dir) };
+
+		//First, we need to ensure that we are not dealing with a uniquely identified file name
+		if (Is_Regular_File_Or_Symlink(path_mask))
+			result.push_back(path_mask);
+		else {
+			//if not, then we are asked to enumerate entire directory, may be with a mask
+
+			const auto effective_path = full_path.parent_path();	//note that path_mask may have already contained a different, than current directory!
+
+			if (Is_Directory(effective_path)) {
+
+				constexpr bool case_sensitive =
+#ifdef  _WIN32
+					false
+#else
+					true
+#endif   
+					;
+
+				std::error_code ec;
+				if (effective_path.empty() || (!filesystem::exists(effective_path, ec) || ec)) {
+					ok = false;
+					return result;
+				}
+
+				for (auto& enumerated_path : filesystem::directory_iterator(effective_path)) {
+					const bool matches_wildcard = Match_Wildcard(enumerated_path.path().filename().wstring(), path_mask, case_sensitive);
+					const bool is_cache = enumerated_path.path().extension().wstring() == Hint_Cache_Extension;
+
+					if (matches_wildcard && !is_cache) {
+						if (Is_Regular_File_Or_Symlink(enumerated_path))
+							result.push_back(enumerated_path.path());
+					}
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+bool Load_Hints(const std::vector<std::wstring>& hint_paths, const size_t expected_parameters_size, const bool parameters_file_type, const bool use_cache, const size_t worker_count, THints& hints) {
+
+	bool ok = false;
+	const auto paths = Enumerate_Hint_Files(hint_paths, ok);
+	if (!ok)
+		return false;
+
+	std::vector<THint_File> files(paths.size());
+	for (size_t i = 0; i < paths.size(); i++)
+		files[i].path = paths[i];
+
+	//1. try the caches and map the remaining files
+	Parallel_For(files.size(), worker_count, [&](const size_t file_index) {
+		THint_File& file = files[file_index];
+		file.stamp = Stamp_Hint_File(file.path, expected_parameters_size, parameters_file_type);
+
+		if (use_cache && Read_Hint_Cache(file))
+			file.cached = true;
+		else {
+			file.values.clear();
+			file.mapping = std::make_unique<CMapped_File>(file.path);
+		}
+	});
+
+	//2. split the mapped files into chunks, so that large files are parsed in parallel too
+	std::vector<THint_Chunk> chunks;
+	for (size_t file_index = 0; file_index < files.size(); file_index++) {
+		const auto& mapping = files[file_index].mapping;
+		if (!mapping || !mapping->data())
+			continue;
+
+		const char* const file_end = mapping->data() + mapping->size();
+		for (const char* chunk_begin = mapping->data(); chunk_begin < file_end; ) {
+			const char* chunk_end = file_end;
+			if (static_cast<size_t>(file_end - chunk_begin) > Hint_Chunk_Size) {
+				//chunks must end with a complete line
+				chunk_end = reinterpret_cast<const char*>(memchr(chunk_begin + Hint_Chunk_Size, '\n', static_cast<size_t>(file_end - chunk_begin - Hint_Chunk_Size)));
+				chunk_end = chunk_end ? chunk_end + 1 : file_end;
+			}
+
+			THint_Chunk chunk;
+			chunk.file_index = file_index;
+			chunk.begin = chunk_begin;
+			chunk.end = chunk_end;
+			chunks.push_back(std::move(chunk));
+
+			chunk_begin = chunk_end;
+		}
+	}
+
+	Parallel_For(chunks.size(), worker_count, [&](const size_t chunk_index) {
+		Parse_Hint_Chunk(chunks[chunk_index], expected_parameters_size, parameters_file_type);
+	});
+
+	//3. chunks are ordered by files and their offsets
+	for (auto& chunk : chunks) {
+		THint_File& file = files[chunk.file_index];
+		file.values.insert(file.values.end(), chunk.values.begin(), chunk.values.end());
+		file.rejected_lines += chunk.rejected_lines;
+	}
+	chunks.clear();
+
+	//4. merge the files into the contiguous buffer and refresh the caches
+	hints.dimension = expected_parameters_size;
+	for (auto& file : files) {
+		if (!file.cached) {
+			if (!file.mapping || !file.mapping->is_open()) {
+				std::wcerr << L"Cannot open the hints file " << file.path.wstring() << std::endl;
+				continue;
+			}
+
+			file.mapping.reset();
+
+			if (file.rejected_lines > 0)
+				std::wcerr << L"Skipped " << file.rejected_lines << L" possibly corrupted lines, or lines with a different than expected hint size, in " << file.path.wstring() << std::endl;
+
+			if (use_cache)
+				Write_Hint_Cache(file);
+		}
+
+		hints.values.insert(hints.values.end(), file.values.begin(), file.values.end());
+
+		std::wcout << L"Loaded " << (expected_parameters_size > 0 ? file.values.size() / expected_parameters_size : 0) << L" additional hints from " << file.path.wstring() << (file.cached ? L" (cached)" : L"") << std::endl;
+	}
+
+	return true;
+}
+
+
+// k-d tree over the bounds-normalized hints, answers fixed-radius queries
+class CHint_Index {
+protected:
+	struct TNode {
+		size_t begin = 0, end = 0;					//range of mIndices, valid for leaves
+		size_t split_dimension = 0;
+		double split_value = 0.0;
+		size_t left = 0, right = 0;					//zero means no child, as the root cannot be a child
+	};
+
+	static constexpr size_t Leaf_Size = 16;
+
+	const size_t mDimension;
+	const std::vector<double>& mPoints;
+	std::vector<size_t> mIndices;
+	std::vector<TNode> mNodes;
+
+	size_t Build(const size_t begin, const size_t end) {
+		const size_t node_index = mNodes.size();
+		mNodes.push_back({ begin, end });
+
+		if (end - begin <= Leaf_Size)
+			return node_index;
+
+		//split along the dimension with the largest spread
+		size_t split_dimension = 0;
+		double largest_spread = -1.0;
+		for (size_t d = 0; d < mDimension; d++) {
+			double lo = std::numeric_limits<double>::max(), hi = std::numeric_limits<double>::lowest();
+			for (size_t i = begin; i < end; i++) {
+				const double value = mPoints[mIndices[i] * mDimension + d];
+				lo = std::min(lo, value);
+				hi = std::max(hi, value);
+			}
+
+			if (hi - lo > largest_spread) {
+				largest_spread = hi - lo;
+				split_dimension = d;
+			}
+		}
+
+		if (largest_spread <= 0.0)
+			return node_index;	//all the points are identical
+
+		const size_t middle = begin + (end - begin) / 2;
+		std::nth_element(mIndices.begin() + begin, mIndices.begin() + middle, mIndices.begin() + end, [&](const size_t a, const size_t b) {
+			return mPoints[a * mDimension + split_dimension] < mPoints[b * mDimension + split_dimension];
+		});
+
+		const size_t left = Build(begin, middle);
+		const size_t right = Build(middle, end);
+
+		TNode& node = mNodes[node_index];
+		node.split_dimension = split_dimension;
+		node.split_value = mPoints[mIndices[middle] * mDimension + split_dimension];
+		node.left = left;
+		node.right = right;
+
+		return node_index;
+	}
+
+	double Distance_Squared(const double* a, const double* b) const {
+		double result = 0.0;
+		for (size_t d = 0; d < mDimension; d++) {
+			const double diff = a[d] - b[d];
+			result += diff * diff;
+		}
+		return result;
+	}
+
+public:
+	CHint_Index(const std::vector<double>& points, const size_t dimension) : mDimension(dimension), mPoints(points) {
+		mIndices.resize(dimension > 0 ? points.size() / dimension : 0);
+		std::iota(mIndices.begin(), mIndices.end(), 0);
+		if (!mIndices.empty())
+			Build(0, mIndices.size());
+	}
+
+	//calls found(index, squared_distance) for every point closer than radius to the query
+	template <typename TFound>
+	void Find_Within(const double* query, const double radius, TFound found) const {
+		if (mNodes.empty())
+			return;
+
+		const double radius_squared = radius * radius;
+		std::vector<size_t> stack{ 0 };
+		while (!stack.empty()) {
+			const TNode& node = mNodes[stack.back()];
+			stack.pop_back();
+
+			if (node.left == 0) {
+				for (size_t i = node.begin; i < node.end; i++) {
+					const double distance = Distance_Squared(query, mPoints.data() + mIndices[i] * mDimension);
+					if (distance < radius_squared)
+						found(mIndices[i], distance);
+				}
+				continue;
+			}
+
+			const double plane_distance = query[node.split_dimension] - node.split_value;
+			const size_t near_child = plane_distance < 0.0 ? node.left : node.right;
+			const size_t far_child = plane_distance < 0.0 ? node.right : node.left;
+
+			stack.push_back(near_child);
+			if (plane_distance * plane_distance < radius_squared)
+				stack.push_back(far_child);
+		}
+	}
+};
+
+std::vector<double> Normalize_Hints(const THints& hints, const std::vector<double>& lower_bound, const std::vector<double>& upper_bound) {
+	std::vector<double> normalized(hints.values.size());
+
+	for (size_t i = 0; i < hints.count(); i++) {
+		for (size_t d = 0; d < hints.dimension; d++) {
+			const double range = (d < lower_bound.size()) && (d < upper_bound.size()) ? upper_bound[d] - lower_bound[d] : 0.0;
+			normalized[i * hints.dimension + d] = range > 0.0 ? (hints.hint(i)[d] - lower_bound[d]) / range : 0.0;	//fixed parameters do not contribute
+		}
+	}
+
+	return normalized;
+}
+
+void Keep_Hints(THints& hints, const std::vector<bool>& keep) {
+	size_t kept_count = 0;
+	for (size_t i = 0; i < hints.count(); i++) {
+		if (keep[i]) {
+			if (kept_count != i)
+				std::copy(hints.hint(i), hints.hint(i) + hints.dimension, hints.hint(kept_count));
+			kept_count++;
+		}
+	}
+
+	hints.values.resize(kept_count * hints.dimension);
+	hints.values.shrink_to_fit();
+}
+
+struct THint_Hash {
+	const THints& hints;
+
+	size_t operator()(const size_t index) const {
+		//FNV-1a over the bit patterns
+		uint64_t hash = 14695981039346656037ull;
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(hints.hint(index));
+		for (size_t i = 0; i < hints.dimension * sizeof(double); i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return static_cast<size_t>(hash);
+	}
+};
+
+struct THint_Equal {
+	const THints& hints;
+
+	bool operator()(const size_t a, const size_t b) const {
+		return memcmp(hints.hint(a), hints.hint(b), hints.dimension * sizeof(double)) == 0;
+	}
+};
+
+void Deduplicate_Hints(THints& hints, const std::vector<double>& lower_bound, const std::vector<double>& upper_bound, const double epsilon) {
+	const size_t initial_count = hints.count();
+	if (initial_count < 2)
+		return;
+
+	//1. exact duplicates
+	std::vector<bool> keep(initial_count, false);
+	{
+		std::unordered_set<size_t, THint_Hash, THint_Equal> unique_hints{ initial_count, THint_Hash{ hints }, THint_Equal{ hints } };
+		for (size_t i = 0; i < initial_count; i++)
+			keep[i] = unique_hints.insert(i).second;
+	}
+	Keep_Hints(hints, keep);
+
+	//2. near duplicates, the first hint of each neighborhood prevails
+	if (epsilon > 0.0) {
+		const std::vector<double> normalized = Normalize_Hints(hints, lower_bound, upper_bound);
+		const CHint_Index index{ normalized, hints.dimension };
+
+		keep.assign(hints.count(), true);
+		for (size_t i = 0; i < hints.count(); i++) {
+			if (!keep[i])
+				continue;
+
+			index.Find_Within(normalized.data() + i * hints.dimension, epsilon, [&](const size_t neighbor, const double) {
+				if (neighbor != i)
+					keep[neighbor] = false;
+			});
+		}
+		Keep_Hints(hints, keep);
+	}
+
+	std::wcout << L"Removed " << initial_count - hints.count() << L" duplicate hints, " << hints.count() << L" hints remain." << std::endl;
+}
+
+void Select_Diverse_Hints(THints& hints, const std::vector<double>& lower_bound, const std::vector<double>& upper_bound, const size_t limit) {
+	const size_t initial_count = hints.count();
+	if ((limit == 0) || (initial_count <= limit))
+		return;
+
+	const std::vector<double> normalized = Normalize_Hints(hints, lower_bound, upper_bound);
+	const CHint_Index index{ normalized, hints.dimension };
+
+	//distance of each hint to the nearest selected one
+	std::vector<double> nearest_selected(initial_count, std::numeric_limits<double>::infinity());
+	std::vector<bool> selected(initial_count, false);
+
+	size_t farthest = 0;	//the first hint seeds the selection
+	for (size_t selected_count = 0; selected_count < limit; selected_count++) {
+		selected[farthest] = true;
+
+		//only hints closer than the current farthest distance can get any closer to the selection
+		const double radius = selected_count == 0 ? std::numeric_limits<double>::max() : std::sqrt(nearest_selected[farthest]);
+		nearest_selected[farthest] = 0.0;
+
+		const double* center = normalized.data() + farthest * hints.dimension;
+		if (selected_count == 0) {
+			for (size_t i = 0; i < initial_count; i++) {
+				double distance = 0.0;
+				for (size_t d = 0; d < hints.dimension; d++) {
+					const double diff = normalized[i * hints.dimension + d] - center[d];
+					distance += diff * diff;
+				}
+				nearest_selected[i] = std::min(nearest_selected[i], distance);
+			}
+		}
+		else
+			index.Find_Within(center, radius, [&](const size_t neighbor, const double distance) {
+				nearest_selected[neighbor] = std::min(nearest_selected[neighbor], distance);
+			});
+
+		farthest = static_cast<size_t>(std::distance(nearest_selected.begin(), std::max_element(nearest_selected.begin(), nearest_selected.end())));
+		if (nearest_selected[farthest] <= 0.0)
+			break;	//the remaining hints duplicate the selected ones
+	}
+
+	Keep_Hints(hints, selected);
+
+	std::wcout << L"Selected " << hints.count() << L" diverse hints out of " << initial_count << L"." << std::endl;
+}
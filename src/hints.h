@@ -0,0 +1,59 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+// all the hints stored row-major in a single contiguous buffer
+struct THints {
+	size_t dimension = 0;
+	std::vector<double> values;
+
+	size_t count() const { return dimension > 0 ? values.size() / dimension : 0; }
+	const double* hint(const size_t index) const { return values.data() + index * dimension; }
+	double* hint(const size_t index) { return values.data() + index * dimension; }
+};
+
+//paths may include wildcard; with use_cache, parsed hints are stored to and loaded from .hintcache sidecar files
+bool Load_Hints(const std::vector<std::wstring>& hint_paths, const size_t expected_parameters_size, const bool parameters_file_type, const bool use_cache, const size_t worker_count, THints& hints);
+
+//removes duplicate hints, and those closer than epsilon in the bounds-normalized space, if epsilon > 0
+void Deduplicate_Hints(THints& hints, const std::vector<double>& lower_bound, const std::vector<double>& upper_bound, const double epsilon);
+//keeps at most limit hints, chosen by farthest-point sampling in the bounds-normalized space
+void Select_Diverse_Hints(THints& hints, const std::vector<double>& lower_bound, const std::vector<double>& upper_bound, const size_t limit);
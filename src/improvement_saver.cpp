@@ -0,0 +1,139 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "improvement_saver.h"
+#include "optimize.h"
+
+CImprovement_Saver::CImprovement_Saver(const TConfiguration_Image& image, const TAction& action, const std::chrono::milliseconds period, const solver::TFitness& initial_fitness, solver::TSolver_Progress& progress)
+	: mImage(image), mAction(action), mPeriod(period), mProgress(progress), mBest_Fitness(initial_fitness) {
+	mThread = std::thread{ &CImprovement_Saver::Saver, this };
+}
+
+CImprovement_Saver::~CImprovement_Saver() {
+	Finish(true);
+}
+
+void CImprovement_Saver::Submit(const solver::TFitness& fitness, const double* parameters, const size_t problem_size) {
+	{
+		std::lock_guard<std::mutex> lock{ mGuard };
+		if (mStop || !Is_Better_Fitness(fitness, mBest_Fitness))
+			return;
+
+		mBest_Fitness = fitness;
+		mPending_Parameters.assign(parameters, parameters + problem_size);
+		mHas_Pending = true;
+	}
+
+	mSignal.notify_all();
+}
+
+HRESULT CImprovement_Saver::Save(const std::vector<double>& parameters) {
+	//a clone of the configuration, so that the solver keeps the original one to itself
+	auto [rc, configuration] = Instantiate_Configuration(mImage, mAction.variables);
+	if (Succeeded(rc))
+		rc = Write_Parameters(configuration, mAction.parameters_to_optimize, parameters);
+	if (Succeeded(rc))
+		rc = Save_Configuration(configuration, mImage.file_path);
+
+	return rc;
+}
+
+void CImprovement_Saver::Saver() {
+	std::unique_lock<std::mutex> lock{ mGuard };
+	auto recent_save = std::chrono::steady_clock::now() - mPeriod;
+
+	while (!mStop) {
+		if (!mHas_Pending) {
+			mSignal.wait(lock);
+			continue;
+		}
+
+		//the rate limit keeps a stream of small improvements from saving all the time
+		const auto next_save = recent_save + mPeriod;
+		if (std::chrono::steady_clock::now() < next_save) {
+			mSignal.wait_until(lock, next_save);
+			continue;
+		}
+
+		const std::vector<double> parameters = std::move(mPending_Parameters);
+		mHas_Pending = false;
+		recent_save = std::chrono::steady_clock::now();
+
+		lock.unlock();
+		const HRESULT rc = Save(parameters);
+		lock.lock();
+
+		if (Succeeded(rc))
+			mSaved_Count++;
+		else if (mFailure == S_OK) {
+			mFailure = rc;
+			mProgress.cancelled = TRUE;
+			std::wcerr << std::endl << L"Failed to save the improved parameters, stopping the optimization! Error: " << Describe_Error(rc) << std::endl;
+		}
+	}
+}
+
+HRESULT CImprovement_Saver::Finish(const bool final_save) {
+	{
+		std::lock_guard<std::mutex> lock{ mGuard };
+		mStop = true;
+	}
+	mSignal.notify_all();
+
+	if (mThread.joinable())
+		mThread.join();
+
+	//the saver thread has finished, so no lock is needed any more
+	if (mHas_Pending) {
+		mHas_Pending = false;
+		if (!final_save) {
+			const HRESULT rc = Save(mPending_Parameters);
+			if (Succeeded(rc))
+				mSaved_Count++;
+			else if (mFailure == S_OK) {
+				mFailure = rc;
+				std::wcerr << std::endl << L"Failed to save the improved parameters! Error: " << Describe_Error(rc) << std::endl;
+			}
+		}
+	}
+
+	return mFailure;
+}
+
+size_t CImprovement_Saver::saved_count() {
+	std::lock_guard<std::mutex> lock{ mGuard };
+	return mSaved_Count;
+}
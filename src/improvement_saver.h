@@ -0,0 +1,82 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include "options.h"
+#include "utils.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// persists the best solution found so far into the configuration file while the optimization still runs;
+// the saves run on their own thread, at most once per period, and only the latest improvement is ever saved;
+// a failed save cancels the optimization, rather than letting it run on for hours without saving anything
+class CImprovement_Saver {
+protected:
+	const TConfiguration_Image mImage;
+	const TAction& mAction;
+	const std::chrono::milliseconds mPeriod;
+	solver::TSolver_Progress& mProgress;
+
+	std::mutex mGuard;
+	std::condition_variable mSignal;
+	solver::TFitness mBest_Fitness;
+	std::vector<double> mPending_Parameters;
+	bool mHas_Pending = false;
+	bool mStop = false;
+	HRESULT mFailure = S_OK;
+	size_t mSaved_Count = 0;
+
+	std::thread mThread;
+
+	void Saver();
+	HRESULT Save(const std::vector<double>& parameters);
+public:
+	//only solutions better than the initial fitness get saved
+	CImprovement_Saver(const TConfiguration_Image& image, const TAction& action, const std::chrono::milliseconds period, const solver::TFitness& initial_fitness, solver::TSolver_Progress& progress);
+	~CImprovement_Saver();
+
+	//ignores solutions, which do not improve the best fitness submitted so far
+	void Submit(const solver::TFitness& fitness, const double* parameters, const size_t problem_size);
+
+	//stops the saving; a pending improvement is saved now, unless the final save supersedes it; returns the first failure
+	HRESULT Finish(const bool final_save);
+	size_t saved_count();
+};
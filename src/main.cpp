@@ -37,6 +37,20 @@
 #include "utils.h"
 #include "options.h"
 #include "optimize.h"
+#include "execute.h"
+#include "batch.h"
+#include "sweep.h"
+#include "telemetry.h"
+#include "server.h"
+#include "cancellation.h"
+#include "affinity.h"
+#include "worker_pool.h"
+#include "columnar_export.h"
+#include "profiler.h"
+#include "stdin_events.h"
+#include "event_log.h"
+#include "startup_timing.h"
+#include "db_access.h"
 
 #include <scgms/rtl/scgmsLib.h>
 #include <scgms/rtl/FilterLib.h>
@@ -48,102 +62,143 @@
 #include <scgms/utils/string_utils.h>
 
 #include <iostream>
-#include <csignal>
 #include <thread>
 #include <climits>
 #include <chrono>
 #include <cmath>
+#include <memory>
 
 #ifdef _WIN32
 	#include <Windows.h>
 #endif
 
-scgms::SFilter_Executor Global_Filter_Executor;
 solver::TSolver_Progress Global_Progress = solver::Null_Solver_Progress; //so that we can cancel from sigint
 
+int Run_Console(int argc, char** argv) {
 
-void MainCalling sighandler(int signo) {
-	// SIGINT should terminate filters; this will eventually terminate whole app
-	if (signo == SIGINT) {
-		std::wcout << std::endl << "Cancelling..." << std::endl;
-
-		Global_Progress.cancelled = TRUE;
+	int result = __LINE__;
 
-		if (Global_Filter_Executor) {
-			scgms::UDevice_Event shut_down_event{ scgms::NDevice_Event_Code::Shut_Down };
-			Global_Filter_Executor.Execute(std::move(shut_down_event));
-		}
+	bool scgms_loaded = false;
+	{
+		CStartup_Phase_Timer library_load_timer{ NStartup_Phase::library_load };
+		scgms_loaded = scgms::is_scgms_loaded();
 	}
-}
-
-int Execute_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const bool save_config) {
-	refcnt::Swstr_list errors;
-	Global_Filter_Executor = scgms::SFilter_Executor{ configuration.get(),
-#ifndef DDO_NOT_USE_QT
-		Setup_Filter_DB_Access,
-#else
-		nullptr,
-#endif
-		nullptr, errors
-	};
-	errors.for_each([](auto str) { std::wcerr << str << std::endl;	});
-
-	if (!Global_Filter_Executor) {
-		std::wcerr << L"Could not execute the filters!" << std::endl;
+	if (!scgms_loaded) {
+		std::wcerr << L"SmartCGMS library is not loaded!" << std::endl;
 		return __LINE__;
 	}
 
-	// wait for filters to finish, or user to close the app
-	Global_Filter_Executor->Terminate(TRUE);
-
-	if (save_config) {
-		std::wcout << L"Saving configuration...";
-		errors = refcnt::Swstr_list{};
-		const HRESULT rc = configuration->Save_To_File(nullptr, errors.get());
-		errors.for_each([](auto str) { std::wcerr << str << std::endl; });
-		if (!Succeeded(rc)) {
-			std::wcerr << std::endl << L"Failed to save the configuration!" << std::endl;
-			std::wcerr << std::endl << L"Error 0x" << std::hex << rc << std::dec << ": "  << Describe_Error(rc) << std::endl;
-			return __LINE__;
-		}
-		else
-			std::wcout << L" saved." << std::endl;
-	}
-
-	return 0;
-}
-
-int MainCalling main(int argc, char** argv) {
-
-	int result = __LINE__;
+	CSignal_Watcher signal_watcher{ Global_Progress };
 
-#ifndef DDO_NOT_USE_QT
-	QCoreApplication app{ argc, argv };	//needed as we expose qdb connector that uses Qt
-#endif
-
-	if (!scgms::is_scgms_loaded()) {
-		std::wcerr << L"SmartCGMS library is not loaded!" << std::endl;
-		return __LINE__;
+	TAction action_to_do;
+	{
+		CStartup_Phase_Timer option_parse_timer{ NStartup_Phase::option_parse };
+		action_to_do = Parse_Options(argc, const_cast<const char**> (argv));
 	}
+	if ((action_to_do.action != NAction::failed_configuration) && !Configure_Affinity(action_to_do))
+		return __LINE__;
+	Worker_Pool().Configure(action_to_do.worker_count);	//the solver instances and batch jobs share the workers, instead of each starting its own
 
-	signal(SIGINT, sighandler);
-
-	TAction action_to_do = Parse_Options(argc, const_cast<const char**> (argv));
-	if (action_to_do.action != NAction::failed_configuration) {
+	if (action_to_do.action == NAction::batch) {
+		//batch jobs load their configurations on their own
+		result = Execute_Batch(action_to_do, Global_Progress);
+	}
+	else if (action_to_do.action == NAction::convert) {
+		//the configuration path names the event stream to convert
+		result = Convert_Event_Log(action_to_do);
+	}
+	else if (action_to_do.action == NAction::serve) {
+		//jobs come with their own configurations, while the loaded libraries stay resident
+		result = Serve(action_to_do, Global_Progress);
+	}
+	else if (action_to_do.action != NAction::failed_configuration) {
 				
+		const auto config_parse_start = std::chrono::steady_clock::now();
 		auto [rc, configuration] = Load_Experimental_Setup(argc, argv, action_to_do.variables);
+		Record_Startup_Phase(NStartup_Phase::config_parse, std::chrono::steady_clock::now() - config_parse_start);
 		if (!Succeeded(rc))
 			return __LINE__;
 
 		switch (action_to_do.action) {
 			case NAction::execute:
-				result = Global_Progress.cancelled == 0 ? Execute_Configuration(configuration, action_to_do.save_config) : __LINE__;
+			{
+				//execution has no solver progress, so the telemetry reports time only
+				const std::atomic<size_t> no_evaluations{ 0 };
+				std::unique_ptr<CTelemetry> telemetry;
+				if (!action_to_do.telemetry_path.empty()) {
+					telemetry = std::make_unique<CTelemetry>(action_to_do.telemetry_path, std::chrono::milliseconds{ action_to_do.telemetry_interval }, Global_Progress, no_evaluations);
+					if (!telemetry->is_open())
+						return __LINE__;
+				}
+
+				//the export is the output of the last filter, and writes on its own thread
+				std::unique_ptr<CColumnar_Export> export_sink;
+				if (!action_to_do.export_path.empty()) {
+					export_sink = std::make_unique<CColumnar_Export>(action_to_do.export_path, Columnar_Max_Pending);
+					if (!export_sink->is_open())
+						return __LINE__;
+				}
+
+				CRun_Budget budget{ Global_Progress, action_to_do.timeout };
+
+				//the profiler runs the chain with a probe in front of each filter
+				std::unique_ptr<CChain_Profiler> profiler;
+				if (action_to_do.profile)
+					profiler = std::make_unique<CChain_Profiler>();
+				scgms::IFilter* output = export_sink.get();
+
+				//events piped from another process enter the first filter, while the events replayed from the event log replace it
+				std::unique_ptr<CStdin_Event_Feeder> stdin_input;
+				std::unique_ptr<CEvent_Log_Feeder> event_log_input;
+				CEvent_Feeder* input = nullptr;
+				if (action_to_do.stdin_events) {
+					stdin_input = std::make_unique<CStdin_Event_Feeder>();
+					input = stdin_input.get();
+				}
+				else if (!action_to_do.event_log_path.empty()) {
+					auto event_log = Acquire_Event_Log(action_to_do.event_log_path);
+					if (!event_log)
+						return __LINE__;
+					event_log_input = std::make_unique<CEvent_Log_Feeder>(event_log);
+					input = event_log_input.get();
+				}
+
+				result = Global_Progress.cancelled == 0 ? Execute_Configuration(configuration, action_to_do.save_config, Global_Progress, output, input, profiler.get()) : __LINE__;
+
+				if (stdin_input) {
+					std::wcout << L"Injected " << stdin_input->injected_count() << L" events from the standard input." << std::endl;
+					if (stdin_input->malformed_count() > 0)
+						std::wcerr << L"Warning: " << stdin_input->malformed_count() << L" malformed events were skipped!" << std::endl;
+				}
+
+				if (profiler) {
+					profiler->Report();
+					if (!action_to_do.profile_trace_path.empty() && !profiler->Write_Trace(action_to_do.profile_trace_path))
+						result = __LINE__;
+				}
+
+				if (export_sink) {
+					if (!export_sink->Finish()) {
+						std::wcerr << L"Failed to write the export file " << action_to_do.export_path << std::endl;
+						result = __LINE__;
+					}
+					else
+						std::wcout << L"Exported " << export_sink->event_count() << L" level events." << std::endl;
+
+					if (export_sink->dropped_count() > 0)
+						std::wcerr << L"Warning: " << export_sink->dropped_count() << L" events were dropped, as the export could not keep up!" << std::endl;
+				}
 				break;
+			}
 
 			case NAction::optimize:
 				result = Global_Progress.cancelled == 0 ? Optimize_Configuration(configuration, action_to_do, Global_Progress) : __LINE__;
 				break;
 
+			case NAction::sweep:
+				result = Global_Progress.cancelled == 0 ? Sweep_Configuration(configuration, action_to_do, Global_Progress) : __LINE__;
+				break;
+
 			default:
 				std::wcout << L"Not-implemented action requested! Action code: " << static_cast<size_t>(action_to_do.action) << std::endl;
 				return __LINE__;
@@ -152,5 +207,15 @@ int MainCalling main(int argc, char** argv) {
 		configuration.reset();	//extraline so that we can take memory snapshot to ease our debugging
 	}
 
+	if (action_to_do.startup_timing)
+		Report_Startup_Timing();
+
+	Report_Worker_Utilization();
+
 	return result;	//so that we can nicely set breakpoints to take memory snapshots
 }
+
+int MainCalling main(int argc, char** argv) {
+	CLazy_DB_Access db_access{ argc, argv };	//Qt starts with the first filter, which needs a database
+	return db_access.Run([&]() { return Run_Console(argc, argv); });
+}
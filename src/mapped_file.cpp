@@ -0,0 +1,100 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "mapped_file.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+CMapped_File::CMapped_File(const filesystem::path& path, const bool single_scan) {
+#ifdef _WIN32
+	mFile = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, single_scan ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	mOpen = GetFileSizeEx(mFile, &size) != FALSE;
+	if (!mOpen || (size.QuadPart == 0))
+		return;
+
+	mMapping = CreateFileMappingW(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping == NULL)
+		return;
+
+	mData = reinterpret_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mData)
+		mSize = static_cast<size_t>(size.QuadPart);
+	else
+		mOpen = false;
+#else
+	const int fd = open(path.string().c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat file_stat;
+	mOpen = fstat(fd, &file_stat) == 0;
+	if (mOpen && (file_stat.st_size > 0)) {
+		void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED) {
+			mData = reinterpret_cast<const char*>(data);
+			mSize = static_cast<size_t>(file_stat.st_size);
+			madvise(data, mSize, single_scan ? MADV_SEQUENTIAL : MADV_WILLNEED);
+		}
+		else
+			mOpen = false;
+	}
+
+	close(fd);	//the mapping stays valid
+#endif
+}
+
+CMapped_File::~CMapped_File() {
+#ifdef _WIN32
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMapping != NULL)
+		CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+#else
+	if (mData)
+		munmap(const_cast<char*>(mData), mSize);
+#endif
+}
@@ -0,0 +1,69 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/FilesystemLib.h>
+
+#include <cstddef>
+
+#ifdef _WIN32
+	#include <Windows.h>
+#endif
+
+// read-only memory map of an entire file
+class CMapped_File {
+protected:
+	const char* mData = nullptr;
+	size_t mSize = 0;
+	bool mOpen = false;
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = NULL;
+#endif
+public:
+	//a single sequential scan lets the system drop the pages behind it, while a file scanned repeatedly is loaded whole at once
+	CMapped_File(const filesystem::path& path, const bool single_scan = true);
+	~CMapped_File();
+
+	CMapped_File(const CMapped_File&) = delete;
+	CMapped_File& operator=(const CMapped_File&) = delete;
+
+	bool is_open() const { return mOpen; }	//note that an empty file is open, but has no data
+	const char* data() const { return mData; }
+	size_t size() const { return mSize; }
+};
@@ -37,94 +37,411 @@
 #include "optimize.h"
 
 #include "utils.h"
+#include "hints.h"
+#include "checkpoint.h"
+#include "execute.h"
+#include "telemetry.h"
+#include "cancellation.h"
+#include "evaluation_cache.h"
+#include "event_log.h"
+#include "improvement_saver.h"
+#include "pareto.h"
 #include <scgms/utils/string_utils.h>
 #include <scgms/utils/system_utils.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
 
-int Optimize_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const TAction& action, solver::TSolver_Progress& progress) {
+constexpr std::chrono::milliseconds Progress_Report_Period{ 500 };	//progress is reported at least this often...
+constexpr std::chrono::milliseconds Progress_Report_Throttle{ 100 };	//...and at most this often
 
-	const size_t optimize_param_count = action.parameters_to_optimize.size();
-	if (optimize_param_count < 1) {
-		std::wcerr << L"Have no parameters to optimize!\n";
-		return __LINE__;
+constexpr size_t Minimum_Island_Population = 10;
+
+bool Is_Better_Fitness(const solver::TFitness& candidate, const solver::TFitness& best) {
+	//lexicographic order, NaN is the worst possible fitness
+	for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
+		const bool candidate_nan = std::isnan(candidate[i]), best_nan = std::isnan(best[i]);
+		if (candidate_nan != best_nan)
+			return best_nan;
+		if (!candidate_nan && (candidate[i] != best[i]))
+			return candidate[i] < best[i];
 	}
 
-	std::vector<size_t> optimize_param_indices;
-	std::vector<const wchar_t*> optimize_param_names;
+	return false;
+}
+
+// stops the whole optimization, once the target fitness is reached or the best fitness stagnates
+class CEarly_Stopping {
+protected:
+	const TAction& mAction;
+	solver::TSolver_Progress& mProgress;
+	std::mutex mGuard;
+	solver::TFitness mBest_Fitness = solver::Max_Fitness;
+	size_t mImprovement_Generation = 0;
+	std::chrono::steady_clock::time_point mImprovement_Time = std::chrono::steady_clock::now();
+	const wchar_t* mReason = nullptr;
+public:
+	CEarly_Stopping(const TAction& action, solver::TSolver_Progress& progress) : mAction(action), mProgress(progress) {}
+
+	bool enabled() const { return !mAction.target_fitness.empty() || (mAction.stagnation_generations > 0) || (mAction.stagnation_seconds > 0.0); }
+	const wchar_t* reason() const { return mReason; }
 
-	for (const auto& param : action.parameters_to_optimize) {
-		optimize_param_indices.push_back(param.index);
-		optimize_param_names.push_back(param.name.c_str());
+	bool Update(const solver::TFitness& fitness, const size_t generation);	//returns true, if the optimization has to stop
+};
+
+bool CEarly_Stopping::Update(const solver::TFitness& fitness, const size_t generation) {
+	std::lock_guard<std::mutex> lock{ mGuard };
+	if (mReason)
+		return true;
+
+	const auto now = std::chrono::steady_clock::now();
+	if (Is_Better_Fitness(fitness, mBest_Fitness)) {
+		mBest_Fitness = fitness;
+		mImprovement_Generation = generation;
+		mImprovement_Time = now;
 	}
 
-	const auto [hint_rc, expected_param_size] = Count_Parameters_Size(configuration, action.parameters_to_optimize);
-	if (hint_rc != S_OK)
-		return __LINE__;
-	std::vector<std::vector<double>> hints;
-	if (!Load_Hints(action.hints_to_load, expected_param_size, false, hints))	//load hints
-		return __LINE__;
+	const bool target_reached = !mAction.target_fitness.empty() && std::all_of(mAction.target_fitness.begin(), mAction.target_fitness.end(), [&](const TTarget_Fitness& target) {
+		return fitness[target.objective] <= target.value;	//NaN never reaches the target
+	});
 
-	if (!Load_Hints(action.hinting_parameters_to_load, expected_param_size, true, hints))	//load parameters
-		return __LINE__;
+	if (target_reached)
+		mReason = L"the target fitness has been reached";
+	else if ((mAction.stagnation_generations > 0) && (generation >= mImprovement_Generation + mAction.stagnation_generations))
+		mReason = L"the fitness has not improved for the given number of generations";
+	else if ((mAction.stagnation_seconds > 0.0) && (std::chrono::duration<double>(now - mImprovement_Time).count() >= mAction.stagnation_seconds))
+		mReason = L"the fitness has not improved for the given time";
 
-	std::vector<const double*> hints_ptr;
-	for (size_t i = 0; i < hints.size(); i++) {
-		hints_ptr.push_back(hints[i].data());
+	if (mReason)
+		mProgress.cancelled = TRUE;	//the solvers finish with their best solutions, which then get saved
+
+	return mReason != nullptr;
+}
+
+// the console evaluates the solutions on its own, instead of the solver filter chain replay, so that it can consult the evaluation cache
+struct TConsole_Objective {
+	const TAction* action = nullptr;
+	solver::TSolver_Progress* progress = nullptr;	//of the whole run, whose cancellation shuts down the running evaluations
+	TConfiguration_Image image;
+	std::vector<double> lower_bound, upper_bound;
+	size_t metrics_count = 0;
+	size_t worker_count = 1;
+	std::unique_ptr<CEvaluation_Cache> cache;
+	std::unique_ptr<CPareto_Archive> archive;
+	CImprovement_Saver* saver = nullptr;
+	std::vector<std::shared_ptr<const CEvent_Log>> event_logs;	//per dataset, replayed by every evaluation in place of the chain's first filter, i.e.; its input
+};
+
+//each distinct log is mapped once, no matter how many datasets, folds and concurrent evaluations replay it
+bool Acquire_Event_Logs(TConsole_Objective& objective) {
+	const TAction& action = *objective.action;
+	if (action.event_log_path.empty())
+		return true;
+
+	const size_t dataset_count = std::max(action.datasets.size(), static_cast<size_t>(1));
+	for (size_t i = 0; i < dataset_count; i++) {
+		auto event_log = Acquire_Event_Log(Dataset_Event_Log_Path(action, i));
+		if (!event_log)
+			return false;
+		objective.event_logs.push_back(std::move(event_log));
+	}
+
+	return true;
+}
+
+//names the first option, which needs the console to evaluate the solutions, as the solver's own replay of the chain cannot serve it
+const wchar_t* Console_Evaluation_Reason(const TAction& action, const bool save_improvements) {
+	if (action.evaluation_cache)
+		return L"--evaluation_cache";
+	if (!action.datasets.empty())
+		return L"--dataset";
+	if (!action.evaluation_log_path.empty())
+		return L"--evaluation_log";
+	if (!action.pareto_front_path.empty())
+		return L"--pareto_front";
+	if (save_improvements)
+		return L"--save_improvements, whose parameters the solver does not report until it finishes";
+	if (!action.event_log_path.empty())
+		return L"--event_log";
+
+	return L"--console_evaluation";
+}
+
+solver::TFitness Metrics_To_Fitness(const std::vector<double>& metrics) {
+	solver::TFitness fitness;
+	fitness.fill(std::numeric_limits<double>::quiet_NaN());
+	std::copy_n(metrics.begin(), std::min(metrics.size(), fitness.size()), fitness.begin());
+	return fitness;
+}
+
+struct TOptimization_Setup {
+	std::vector<size_t> param_indices;
+	std::vector<const wchar_t*> param_names;
+	std::atomic<size_t>* objective_evaluations = nullptr;	//solutions actually evaluated, i.e.; neither the cached ones, nor per metric filter
+	size_t chain_filter_count = 1;							//each evaluation of scgms::Optimize_Parameters creates all the filters of the chain once
+	std::atomic<size_t> created_filter_count{ 0 };
+	const solver::TSolver_Progress* cancel_source = nullptr;	//propagates cancellation to solvers with their own progress
+	CEarly_Stopping* early_stopping = nullptr;
+	size_t generation_offset = 0;							//generations completed by the previous segments
+	TConsole_Objective* console_objective = nullptr;		//replaces scgms::Optimize_Parameters with solver::Solve_Generic
+
+	//wakes up the progress monitor once the solver finishes, or improves the fitness
+	const solver::TSolver_Progress* progress = nullptr;
+	std::mutex monitor_guard;
+	std::condition_variable monitor_signal;
+	bool solver_finished = false;
+	std::atomic<double> monitored_fitness{ std::numeric_limits<double>::max() };
+};
+
+void Notify_Improvement(TOptimization_Setup* setup) {
+	//new evaluation means that the solver may have updated the best fitness with the previous one
+	if (setup->progress && (setup->progress->best_metric[0] < setup->monitored_fitness)) {
+		setup->monitored_fitness = setup->progress->best_metric[0];
+		setup->monitor_signal.notify_all();
+	}
+}
+
+HRESULT IfaceCalling On_Solver_Filter_Created(scgms::IFilter* filter, const void* data) {
+	auto setup = reinterpret_cast<TOptimization_Setup*>(const_cast<void*>(data));
+	if (++setup->created_filter_count % setup->chain_filter_count == 0)
+		(*setup->objective_evaluations)++;
+	if (Is_Metric_Filter(filter))
+		Notify_Improvement(setup);
+
+	return On_Filter_Created(filter, nullptr);
+}
+
+std::tuple<HRESULT, std::vector<double>> Evaluate_Solution(const TConsole_Objective& objective, const double* solution, const size_t dataset_index, solver::TSolver_Progress& progress) {
+	const TAction& action = *objective.action;
+
+	//each dataset is just another value of the dataset variable
+	std::vector<TVariable> variables = action.variables;
+	if (!action.datasets.empty())
+		variables.push_back(TVariable{ action.dataset_variable, action.datasets[dataset_index] });
+
+	auto [rc, configuration] = Instantiate_Configuration(objective.image, variables);
+	if (Succeeded(rc))
+		rc = Write_Parameters(configuration, action.parameters_to_optimize, std::vector<double>{ solution, solution + objective.lower_bound.size() });
+	if (!Succeeded(rc))
+		return { rc, {} };
+
+	std::unique_ptr<CEvent_Log_Feeder> input;
+	if (!objective.event_logs.empty())
+		input = std::make_unique<CEvent_Log_Feeder>(objective.event_logs[dataset_index % objective.event_logs.size()]);
+
+	return Evaluate_Configuration(configuration, progress, input.get());
+}
+
+double Aggregate_Metric(std::vector<double>& values, const TAction& action) {
+	switch (action.aggregation) {
+		case NMetric_Aggregation::max:
+			return *std::max_element(values.begin(), values.end());
+
+		case NMetric_Aggregation::percentile:
+		{
+			//linear interpolation between the closest ranks
+			std::sort(values.begin(), values.end());
+			const double rank = action.aggregation_percentile * 0.01 * static_cast<double>(values.size() - 1);
+			const size_t lower_rank = static_cast<size_t>(std::floor(rank));
+			const size_t upper_rank = std::min(lower_rank + 1, values.size() - 1);
+			return values[lower_rank] + (rank - static_cast<double>(lower_rank)) * (values[upper_rank] - values[lower_rank]);
+		}
+
+		default:
+			return std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+	}
+}
+
+//evaluates the solutions over all the datasets concurrently, and aggregates the metrics over the datasets; failed solutions get empty metrics
+//once the run, or the optional solver progress, gets cancelled, the evaluations, which have not started yet, do not start at all
+//the optional evaluated count receives the number of the solutions, which were not found in the cache
+std::vector<std::vector<double>> Evaluate_Solutions(const TConsole_Objective& objective, const size_t solution_count, const double* solutions, const solver::TSolver_Progress* solver_progress, size_t* evaluated_count = nullptr) {
+	const size_t problem_size = objective.lower_bound.size();
+	const size_t dataset_count = std::max(objective.action->datasets.size(), static_cast<size_t>(1));
+
+	std::vector<std::vector<double>> metrics(solution_count);
+	std::vector<size_t> pending;
+	for (size_t i = 0; i < solution_count; i++)
+		if (!objective.cache || !objective.cache->Find(solutions + i * problem_size, metrics[i]))
+			pending.push_back(i);
+	if (evaluated_count)
+		*evaluated_count = pending.size();
+
+	//solutions times datasets make a single pool of tasks, so that neither level waits for the other
+	std::vector<std::vector<double>> dataset_metrics(pending.size() * dataset_count);
+	Parallel_For(dataset_metrics.size(), objective.worker_count, [&](const size_t task) {
+		if ((objective.progress->cancelled != FALSE) || (solver_progress && (solver_progress->cancelled != FALSE)))
+			return;
+
+		//the executor registers with the progress of the run, so that Cancel_Execution reaches it
+		const auto [rc, task_metrics] = Evaluate_Solution(objective, solutions + pending[task / dataset_count] * problem_size, task % dataset_count, *objective.progress);
+		if (rc == S_OK)
+			dataset_metrics[task] = task_metrics;
+	});
+
+	for (size_t i = 0; i < pending.size(); i++) {
+		const auto first = dataset_metrics.begin() + i * dataset_count;
+		const size_t metrics_count = first->size();
+		const bool all_evaluated = (metrics_count > 0) && std::all_of(first, first + dataset_count, [=](const std::vector<double>& values) { return values.size() == metrics_count; });
+		if (!all_evaluated)
+			continue;	//failed or cancelled evaluations must not be remembered
+
+		auto& solution_metrics = metrics[pending[i]];
+		for (size_t j = 0; j < metrics_count; j++) {
+			std::vector<double> values;
+			for (auto dataset = first; dataset != first + dataset_count; dataset++)
+				values.push_back((*dataset)[j]);
+			solution_metrics.push_back(Aggregate_Metric(values, *objective.action));
+		}
+
+		if (objective.cache)
+			objective.cache->Store(solutions + pending[i] * problem_size, solution_metrics);
+	}
+
+	return metrics;
+}
+
+BOOL IfaceCalling Console_Objective_Function(const void* data, const size_t solution_count, const double* solutions, double* const fitnesses) {
+	auto setup = reinterpret_cast<TOptimization_Setup*>(const_cast<void*>(data));
+	const TConsole_Objective& objective = *setup->console_objective;
+
+	size_t evaluated_count = 0;
+	const auto metrics = Evaluate_Solutions(objective, solution_count, solutions, setup->progress, &evaluated_count);
+	if (objective.archive)
+		objective.archive->Record(solution_count, solutions, metrics);
+	for (size_t i = 0; i < solution_count; i++) {
+		double* fitness = fitnesses + i * solver::Maximum_Objectives_Count;
+		for (size_t j = 0; j < objective.metrics_count; j++)
+			fitness[j] = j < metrics[i].size() ? metrics[i][j] : std::numeric_limits<double>::max();
+
+		if (objective.saver && (metrics[i].size() == objective.metrics_count))
+			objective.saver->Submit(Metrics_To_Fitness(metrics[i]), solutions + i * objective.lower_bound.size(), objective.lower_bound.size());
 	}
 
+	(*setup->objective_evaluations) += evaluated_count;	//cache hits are reported by the cache
+	Notify_Improvement(setup);
+
+	return TRUE;
+}
+
+HRESULT Run_Solver(scgms::SPersistent_Filter_Chain_Configuration& configuration, TOptimization_Setup& setup, const GUID& solver_id, const size_t population_size, const size_t generation_count,
+	std::vector<const double*>& hints_ptr, solver::TSolver_Progress& progress, const bool report) {
+
 	refcnt::Swstr_list errors;
 
-	CPriority_Guard priority_guard;
+	setup.progress = &progress;
+	setup.solver_finished = false;
+	setup.monitored_fitness = progress.best_metric[0];
 
 	HRESULT rc = E_FAIL;
-	std::atomic<bool> optimizing_flag{ true };
 	std::thread optimitizing_thread([&] {
 		//use thread, not async because that could live-lock on a uniprocessor
 
-		rc = scgms::Optimize_Parameters(configuration,
-			optimize_param_indices.data(), optimize_param_names.data(), optimize_param_count,
-#ifndef DDO_NOT_USE_QT
-			Setup_Filter_DB_Access
-#else
-			nullptr
-#endif
-			, nullptr,
-			action.solver_id, action.population_size, action.generation_count,
-			hints_ptr.data(), hints_ptr.size(),
-			progress, errors);
-
-		optimizing_flag = false;
+		if (setup.console_objective) {
+			TConsole_Objective& objective = *setup.console_objective;
+			auto [read_rc, lbound, solution, ubound] = Read_Parameters(configuration, objective.action->parameters_to_optimize);
+
+			solver::TSolver_Setup solver_setup{
+				solution.size(), objective.metrics_count,
+				objective.lower_bound.data(), objective.upper_bound.data(),
+				hints_ptr.data(), hints_ptr.size(),
+				solution.data(),
+				&setup, Console_Objective_Function,
+				generation_count, population_size,
+				0.0	//no tolerance, i.e.; all the generations
+			};
+
+			rc = read_rc == S_OK ? solver::Solve_Generic(solver_id, solver_setup, progress) : E_FAIL;
+			if (rc == S_OK)
+				rc = Write_Parameters(configuration, objective.action->parameters_to_optimize, solution);
+		}
+		else
+			rc = scgms::Optimize_Parameters(configuration,
+				setup.param_indices.data(), setup.param_names.data(), setup.param_indices.size(),
+				On_Solver_Filter_Created, &setup,
+				solver_id, population_size, generation_count,
+				hints_ptr.data(), hints_ptr.size(),
+				progress, errors);
+
+		{
+			std::lock_guard<std::mutex> lock{ setup.monitor_guard };
+			setup.solver_finished = true;
+		}
+		setup.monitor_signal.notify_all();
 	});
 
 	double recent_percentage = std::numeric_limits<double>::quiet_NaN();
 	solver::TFitness recent_fitness = solver::Max_Fitness;
-	std::wcout << "Will report progress and best fitness. Optimizing...";
-	while (optimizing_flag) {
-		if (progress.max_progress != 0) {
-			double current_percentage = static_cast<double>(progress.current_progress) / static_cast<double>(progress.max_progress);
-			current_percentage = std::trunc(current_percentage * 1000.0);
-			current_percentage *= 0.1;
-			current_percentage = std::min(current_percentage, 100.0);
-
-			if (recent_percentage != current_percentage) {
-				recent_percentage = current_percentage;
-				std::wcout << " " << current_percentage << "%...";
-
-				for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
-					const double tmp_best = progress.best_metric[i];
-					if ((recent_fitness[i] > tmp_best) && (!std::isnan(tmp_best))) {
-						recent_fitness[i] = tmp_best;
-
-						std::wcout << L' ' << i << L':' << tmp_best;
-					}
-				}
+	size_t recent_front_size = 0;
+	auto report_progress = [&]() {
+		if (progress.max_progress == 0)
+			return;
+
+		double current_percentage = static_cast<double>(progress.current_progress) / static_cast<double>(progress.max_progress);
+		current_percentage = std::trunc(current_percentage * 1000.0);
+		current_percentage *= 0.1;
+		current_percentage = std::min(current_percentage, 100.0);
+
+		bool reported = false;
+		if (recent_percentage != current_percentage) {
+			recent_percentage = current_percentage;
+			std::wcout << " " << current_percentage << "%...";
+			reported = true;
+		}
 
-				std::wcout.flush();
+		//the minima of the individual objectives come from different solutions, so the front tells more
+		const TConsole_Objective* objective = setup.console_objective;
+		if (objective && objective->archive && (objective->metrics_count > 1)) {
+			const size_t front_size = objective->archive->front_size();
+			if (front_size != recent_front_size) {
+				recent_front_size = front_size;
+				std::wcout << L" front:" << front_size;
+				reported = true;
 			}
 		}
+		else {
+			for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
+				const double tmp_best = progress.best_metric[i];
+				if ((recent_fitness[i] > tmp_best) && (!std::isnan(tmp_best))) {
+					recent_fitness[i] = tmp_best;
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+					std::wcout << L' ' << i << L':' << tmp_best;
+					reported = true;
+				}
+			}
+		}
+
+		if (reported)
+			std::wcout.flush();
+	};
+
+	if (report)
+		std::wcout << "Will report progress and best fitness. Optimizing...";
+	{
+		std::unique_lock<std::mutex> lock{ setup.monitor_guard };
+		auto recent_report = std::chrono::steady_clock::now() - Progress_Report_Period;
+
+		while (!setup.solver_finished) {
+			//wakes up on timeout, improvement or finish; the throttle keeps frequent improvements from flooding the output
+			setup.monitor_signal.wait_until(lock, std::max(recent_report + Progress_Report_Period, std::chrono::steady_clock::now() + Progress_Report_Throttle));
+
+			if (setup.cancel_source && (setup.cancel_source->cancelled != FALSE))
+				progress.cancelled = TRUE;
+
+			if (setup.early_stopping && setup.early_stopping->Update(progress.best_metric, setup.generation_offset + progress.current_progress))
+				progress.cancelled = TRUE;
+
+			const auto now = std::chrono::steady_clock::now();
+			if (!setup.solver_finished && (now - recent_report >= Progress_Report_Throttle)) {
+				recent_report = now;
+				if (report)
+					report_progress();
+			}
+		}
 	}
 
 	if (optimitizing_thread.joinable())
@@ -132,18 +449,479 @@ int Optimize_Configuration(scgms::SPersistent_Filter_Chain_Configuration configu
 
 	errors.for_each([](auto str) { std::wcerr << str << std::endl;	});
 
-	if (rc == S_OK) {
+	return rc;
+}
+
+// forwards the cancellation of the whole run (a signal, or a cancelled job) into the progress of a single fold,
+// whose own early stopping and budget cancel just that fold
+class CCancel_Forwarder {
+protected:
+	std::mutex mStop_Guard;
+	std::condition_variable mStop_Signal;
+	bool mStop = false;
+	std::thread mForwarder;
+public:
+	CCancel_Forwarder(const solver::TSolver_Progress& source, solver::TSolver_Progress& target) {
+		mForwarder = std::thread{ [this, &source, &target]() {
+			std::unique_lock<std::mutex> lock{ mStop_Guard };
+			while (!mStop_Signal.wait_for(lock, Progress_Report_Throttle, [this]() { return mStop; })) {
+				if (source.cancelled != FALSE) {
+					Cancel_Execution(target);	//shuts down the evaluations, which run under the target progress
+					break;
+				}
+			}
+		} };
+	}
+
+	~CCancel_Forwarder() {
+		{
+			std::lock_guard<std::mutex> lock{ mStop_Guard };
+			mStop = true;
+		}
+		mStop_Signal.notify_all();
+		mForwarder.join();
+	}
+};
+
+// independent solver run, possibly on a cloned configuration, see the island model in Optimize_Configuration
+struct TIsland {
+	GUID solver_id = Invalid_GUID;
+	scgms::SPersistent_Filter_Chain_Configuration configuration;
+	TOptimization_Setup setup;
+	solver::TSolver_Progress own_progress = solver::Null_Solver_Progress;
+	solver::TSolver_Progress* progress = &own_progress;
+	HRESULT rc = S_FALSE;
+};
+
+//k-fold cross-validation over the datasets; each fold is optimized on the other folds, and evaluated on its own datasets
+int Cross_Validate(const TAction& action, solver::TSolver_Progress& progress) {
+	const auto [image_ok, image] = Load_Configuration_Image(action.config_path);
+	if (!image_ok)
+		return __LINE__;
+
+	std::vector<solver::TFitness> held_out_fitness;
+	for (size_t fold = 0; (fold < action.folds) && (progress.cancelled == FALSE); fold++) {
+		TAction training_action = action, held_out_action = action;
+		training_action.datasets.clear();
+		held_out_action.datasets.clear();
+		for (size_t i = 0; i < action.datasets.size(); i++)
+			(i % action.folds == fold ? held_out_action : training_action).datasets.push_back(action.datasets[i]);
+
+		//folds only estimate the fitness on unseen data, so they neither save, nor persist anything
+		training_action.folds = 0;
+		training_action.discard_result = true;
+		training_action.checkpoint_path.clear();
+		training_action.resume_path.clear();
+		training_action.telemetry_path.clear();
+		training_action.evaluation_cache_path.clear();
+		training_action.evaluation_log_path.clear();
+		training_action.pareto_front_path.clear();
+
+		std::wcout << std::endl << L"Fold " << fold + 1 << L'/' << action.folds << L": optimizing on " << training_action.datasets.size()
+			<< L" datasets, holding out " << held_out_action.datasets.size() << L'.' << std::endl;
+
+		auto [rc, fold_configuration] = Instantiate_Configuration(image, action.variables);
+		if (!Succeeded(rc))
+			return __LINE__;
+
+		//a fold, which stops early, must not cancel the next folds, nor the evaluation of its held-out datasets
+		solver::TSolver_Progress fold_progress = solver::Null_Solver_Progress;
+		int fold_rc = __LINE__;
+		{
+			CCancel_Forwarder cancel_forwarder{ progress, fold_progress };
+			fold_rc = Optimize_Configuration(fold_configuration, training_action, fold_progress);
+		}
+		if (fold_rc != 0)
+			return __LINE__;
+
+		const auto [read_rc, lower_bound, parameters, upper_bound] = Read_Parameters(fold_configuration, action.parameters_to_optimize);
+		if (read_rc != S_OK)
+			return __LINE__;
+
+		TConsole_Objective held_out_objective;
+		held_out_objective.action = &held_out_action;
+		held_out_objective.progress = &progress;
+		held_out_objective.image = image;
+		held_out_objective.lower_bound = lower_bound;
+		held_out_objective.upper_bound = upper_bound;
+		held_out_objective.worker_count = Resolve_Worker_Count(action.worker_count);
+		if (!Acquire_Event_Logs(held_out_objective))
+			return __LINE__;
+
+		const auto metrics = Evaluate_Solutions(held_out_objective, 1, parameters.data(), nullptr)[0];
+		if (metrics.empty() || (metrics.size() > solver::Maximum_Objectives_Count)) {
+			std::wcerr << L"Cannot evaluate the held-out datasets of fold " << fold + 1 << L'!' << std::endl;
+			return __LINE__;
+		}
+
+		solver::TFitness fitness;
+		fitness.fill(std::numeric_limits<double>::quiet_NaN());
+		std::copy(metrics.begin(), metrics.end(), fitness.begin());
+		held_out_fitness.push_back(fitness);
+
+		std::wcout << L"Fold " << fold + 1 << L" held-out fitness:";
+		for (size_t i = 0; i < metrics.size(); i++)
+			std::wcout << L' ' << i << L':' << metrics[i];
+		std::wcout << std::endl;
+	}
+
+	if (held_out_fitness.size() < action.folds) {
+		std::wcerr << L"Cross-validation was cancelled." << std::endl;
+		return __LINE__;
+	}
+
+	std::wcout << std::endl << L"Mean held-out fitness over " << action.folds << L" folds:";
+	for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
+		double sum = 0.0;
+		for (const auto& fitness : held_out_fitness)
+			sum += fitness[i];
+		if (!std::isnan(sum))
+			std::wcout << L' ' << i << L':' << sum / static_cast<double>(held_out_fitness.size());
+	}
+	std::wcout << std::endl << std::endl << L"Optimizing on all the datasets..." << std::endl;
+
+	return 0;
+}
+
+int Optimize_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const TAction& action, solver::TSolver_Progress& progress, TOptimization_Stats* stats) {
+
+	const size_t optimize_param_count = action.parameters_to_optimize.size();
+	if (optimize_param_count < 1) {
+		std::wcerr << L"Have no parameters to optimize!\n";
+		return __LINE__;
+	}
+
+	if (action.folds > 1) {
+		const int cross_validation_rc = Cross_Validate(action, progress);
+		if (cross_validation_rc != 0)
+			return cross_validation_rc;
+	}
+
+	const auto [hint_rc, lower_bound, initial_parameters, upper_bound] = Read_Parameters(configuration, action.parameters_to_optimize);
+	if (hint_rc != S_OK)
+		return __LINE__;
+	const size_t expected_param_size = initial_parameters.size();
+
+	THints hints;
+	if (!Load_Hints(action.hints_to_load, expected_param_size, false, action.hint_cache, action.worker_count, hints))	//load hints
+		return __LINE__;
+
+	if (!Load_Hints(action.hinting_parameters_to_load, expected_param_size, true, action.hint_cache, action.worker_count, hints))	//load parameters
+		return __LINE__;
+
+	if (action.hint_deduplication)
+		Deduplicate_Hints(hints, lower_bound, upper_bound, action.hint_epsilon);
+
+	Select_Diverse_Hints(hints, lower_bound, upper_bound, action.hint_limit);
+
+	std::vector<const double*> hints_ptr;
+	for (size_t i = 0; i < hints.count(); i++) {
+		hints_ptr.push_back(hints.hint(i));
+	}
+
+	HRESULT rc = S_FALSE;
+	bool improved = false;
+	std::vector<double> best_parameters;
+
+	//resumed optimization continues from the checkpoint, whose parameters become the first hint
+	TCheckpoint checkpoint;
+	if (!action.resume_path.empty()) {
+		if (!Read_Checkpoint(action.resume_path, checkpoint))
+			return __LINE__;
+
+		if ((checkpoint.parameters.size() != expected_param_size) || (Write_Parameters(configuration, action.parameters_to_optimize, checkpoint.parameters) != S_OK)) {
+			std::wcerr << L"The checkpoint " << action.resume_path << L" holds different parameters than expected!" << std::endl;
+			return __LINE__;
+		}
+
+		improved = true;
+		best_parameters = checkpoint.parameters;
+		std::wcout << L"Resuming after " << checkpoint.completed_generations << L" generations." << std::endl;
+	}
+
+	//a single island optimizes the configuration itself, multiple islands optimize its clones
+	const size_t island_count = std::max(action.restarts, action.solver_ids.size());
+	const size_t island_population = island_count > 1 ? std::max(action.population_size / island_count, Minimum_Island_Population) : action.population_size;
+	std::atomic<size_t> objective_evaluations{ 0 };
+	CEarly_Stopping early_stopping{ action, progress };
+
+	std::vector<std::unique_ptr<TIsland>> islands;
+	TConfiguration_Image image;
+	const bool save_improvements = action.save_improvements && !action.discard_result;
+	const bool console_evaluation = action.console_evaluation || action.evaluation_cache || !action.datasets.empty() || !action.evaluation_log_path.empty() || !action.pareto_front_path.empty() || save_improvements || !action.event_log_path.empty();
+	if ((island_count > 1) || console_evaluation) {
+		bool image_ok = false;
+		std::tie(image_ok, image) = Load_Configuration_Image(action.config_path);
+		if (!image_ok)
+			return __LINE__;
+	}
+
+	//with the evaluation cache, log, Pareto front, saving on improvement, event log replay or datasets, the console evaluates the solutions, starting with the initial ones to learn the number of metrics
+	std::unique_ptr<TConsole_Objective> console_objective;
+	std::unique_ptr<CImprovement_Saver> saver;
+	if (console_evaluation) {
+		//the console instantiates the configuration for every solution and dataset, i.e.; it is slower than the solver's own replay, unless the workers make up for it
+		if (!action.console_evaluation)
+			std::wcout << L"The console evaluates the solutions, instead of the solver, because of " << Console_Evaluation_Reason(action, save_improvements) << L"." << std::endl;
+
+		console_objective = std::make_unique<TConsole_Objective>();
+		console_objective->action = &action;
+		console_objective->progress = &progress;
+		console_objective->image = image;
+		console_objective->lower_bound = lower_bound;
+		console_objective->upper_bound = upper_bound;
+		console_objective->worker_count = Resolve_Worker_Count(action.worker_count);
+		if (!Acquire_Event_Logs(*console_objective))
+			return __LINE__;
+		if (!console_objective->event_logs.empty()) {
+			const auto log_stats = Event_Log_Cache_Stats();
+			std::wcout << L"Evaluations replay " << log_stats.log_count << L" event logs, of " << static_cast<double>(log_stats.mapped_size) / (1024.0 * 1024.0) << L" MiB in total." << std::endl;
+		}
+
+		const auto initial_metrics = Evaluate_Solutions(*console_objective, 1, initial_parameters.data(), nullptr)[0];
+		if (initial_metrics.empty() || (initial_metrics.size() > solver::Maximum_Objectives_Count)) {
+			std::wcerr << L"Cannot evaluate the metrics of the initial parameters!" << std::endl;
+			return __LINE__;
+		}
+
+		console_objective->metrics_count = initial_metrics.size();
+		if (!action.datasets.empty())
+			std::wcout << L"Each evaluation runs " << action.datasets.size() << L" datasets." << std::endl;
+
+		if (action.evaluation_cache) {
+			console_objective->cache = std::make_unique<CEvaluation_Cache>(Hash_Configuration(image, action), expected_param_size, initial_metrics.size());
+			if (!action.evaluation_cache_path.empty() && console_objective->cache->Load(action.evaluation_cache_path))
+				std::wcout << L"Loaded " << console_objective->cache->size() << L" cached evaluations." << std::endl;
+			console_objective->cache->Store(initial_parameters.data(), initial_metrics);
+		}
+
+		if (!action.evaluation_log_path.empty() || !action.pareto_front_path.empty()) {
+			console_objective->archive = std::make_unique<CPareto_Archive>(expected_param_size, initial_metrics.size(), action.evaluation_log_path);
+			if (!console_objective->archive->is_open())
+				return __LINE__;
+			console_objective->archive->Record(1, initial_parameters.data(), { initial_metrics });
+		}
+
+		if (save_improvements) {
+			const auto period = std::chrono::milliseconds{ static_cast<int64_t>(action.save_improvements_period * 1000.0) };
+			saver = std::make_unique<CImprovement_Saver>(image, action, period, Metrics_To_Fitness(initial_metrics), progress);
+			console_objective->saver = saver.get();
+		}
+	}
+
+	for (size_t i = 0; i < island_count; i++) {
+		auto island = std::make_unique<TIsland>();
+		island->solver_id = action.solver_ids.empty() ? action.solver_id : action.solver_ids[i % action.solver_ids.size()];
+		island->setup.objective_evaluations = &objective_evaluations;
+		island->setup.early_stopping = early_stopping.enabled() ? &early_stopping : nullptr;
+		island->setup.console_objective = console_objective.get();
+
+		for (const auto& param : action.parameters_to_optimize) {
+			island->setup.param_indices.push_back(param.index);
+			island->setup.param_names.push_back(param.name.c_str());
+		}
+
+		if (island_count > 1) {
+			HRESULT clone_rc = E_FAIL;
+			std::tie(clone_rc, island->configuration) = Instantiate_Configuration(image, action.variables);
+			if (Succeeded(clone_rc) && improved)
+				clone_rc = Write_Parameters(island->configuration, action.parameters_to_optimize, best_parameters);
+			if (!Succeeded(clone_rc))
+				return __LINE__;
+
+			island->setup.cancel_source = &progress;
+		}
+		else {
+			island->configuration = configuration;
+			island->progress = &progress;
+		}
+
+		scgms::IFilter_Configuration_Link **link_begin = nullptr, **link_end = nullptr;
+		if ((island->configuration->get(&link_begin, &link_end) == S_OK) && (link_end > link_begin))
+			island->setup.chain_filter_count = static_cast<size_t>(link_end - link_begin);
+
+		islands.push_back(std::move(island));
+	}
+
+	if (island_count > 1)
+		std::wcout << L"Running " << island_count << L" solver instances with population size " << island_population << L" each." << std::endl;
+
+	CPriority_Guard priority_guard;
+
+	std::unique_ptr<CTelemetry> telemetry;
+	if (!action.telemetry_path.empty()) {
+		telemetry = std::make_unique<CTelemetry>(action.telemetry_path, std::chrono::milliseconds{ action.telemetry_interval }, progress, objective_evaluations);
+		if (!telemetry->is_open())
+			return __LINE__;
+	}
+
+	const auto optimization_start = std::chrono::steady_clock::now();
+	auto budget = std::make_unique<CRun_Budget>(progress, action.timeout, action.max_evaluations, &objective_evaluations);
+
+	//with periodic checkpoints or islands, the optimization runs in segments, each seeded with the best solution of the previous one;
+	//a new segment restarts the solver with a new population, so a checkpoint alone is written just once the run ends, or gets cancelled
+	size_t segment_generations = action.generation_count;
+	if (action.checkpoint_generations > 0)
+		segment_generations = std::min(segment_generations, action.checkpoint_generations);
+	if (island_count > 1)
+		segment_generations = std::min(segment_generations, action.migration_generations);
+	segment_generations = std::max(segment_generations, static_cast<size_t>(1));
+
+	while ((checkpoint.completed_generations < action.generation_count) && (progress.cancelled == FALSE)) {
+		const size_t generation_count = std::min(segment_generations, action.generation_count - checkpoint.completed_generations);
+
+		std::vector<const double*> segment_hints_ptr = hints_ptr;
+		if (improved)
+			segment_hints_ptr.insert(segment_hints_ptr.begin(), best_parameters.data());
+
+		for (auto& island : islands)
+			island->setup.generation_offset = checkpoint.completed_generations;
+
+		if (island_count == 1) {
+			auto& island = *islands[0];
+			island.rc = Run_Solver(island.configuration, island.setup, island.solver_id, island_population, generation_count, segment_hints_ptr, *island.progress, true);
+		}
+		else {
+			std::vector<std::thread> island_threads;
+			for (auto& island : islands) {
+				island_threads.push_back(std::thread{ [&, island_ptr = island.get()]() {
+					std::vector<const double*> island_hints_ptr = segment_hints_ptr;
+					island_ptr->rc = Run_Solver(island_ptr->configuration, island_ptr->setup, island_ptr->solver_id, island_population, generation_count, island_hints_ptr, *island_ptr->progress, false);
+				} });
+			}
+
+			for (auto& thread : island_threads)
+				thread.join();
+		}
+
+		//migrate the best solution among the islands
+		bool any_succeeded = false;
+		for (size_t i = 0; i < islands.size(); i++) {
+			auto& island = *islands[i];
+			if ((island.rc != S_OK) && (island.rc != S_FALSE)) {
+				rc = island.rc;
+				std::wcerr << L"Solver instance no. " << i << L" failed! Error: " << Describe_Error(island.rc) << std::endl;
+				continue;
+			}
+
+			any_succeeded = true;
+			if ((island.rc == S_OK) && ((island_count == 1) || Is_Better_Fitness(island.progress->best_metric, checkpoint.best_metric))) {
+				const auto [read_rc, lbound, params, ubound] = Read_Parameters(island.configuration, action.parameters_to_optimize);
+				if (read_rc == S_OK) {
+					improved = true;
+					best_parameters = params;
+					checkpoint.best_metric = island.progress->best_metric;
+					if (saver)
+						saver->Submit(checkpoint.best_metric, best_parameters.data(), best_parameters.size());
+				}
+			}
+		}
+
+		if (!any_succeeded)
+			break;
+
+		//a cancelled segment has not run all its generations, and resuming must not skip those it did not run
+		size_t completed_generations = generation_count;
+		for (const auto& island : islands)
+			if (island->progress->cancelled != FALSE)
+				completed_generations = std::min(completed_generations, static_cast<size_t>(island->progress->current_progress));
+		checkpoint.completed_generations += completed_generations;
+
+		if (island_count > 1) {
+			progress.current_progress = checkpoint.completed_generations;
+			progress.max_progress = action.generation_count;
+			progress.best_metric = checkpoint.best_metric;
+
+			std::wcout << L"\nAfter " << checkpoint.completed_generations << L" generations, best fitness:";
+			for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++)
+				if (!std::isnan(checkpoint.best_metric[i]))
+					std::wcout << L' ' << i << L':' << checkpoint.best_metric[i];
+		}
+
+		if (!action.checkpoint_path.empty() && improved) {
+			checkpoint.parameters = best_parameters;
+			if (Write_Checkpoint(action.checkpoint_path, checkpoint))
+				std::wcout << L"\nCheckpoint written after " << checkpoint.completed_generations << L" generations.";
+		}
+	}
+
+	if (early_stopping.reason())
+		std::wcout << std::endl << L"Optimization stopped early, because " << early_stopping.reason() << L'.' << std::endl;
+	if (budget->exhausted()) {
+		std::wcout << std::endl << L"Budget exhausted after " << objective_evaluations << L" objective evaluations";
+		if (console_objective && console_objective->cache)
+			std::wcout << L" and " << console_objective->cache->hits() << L" cache hits";
+		std::wcout << L", keeping the best solution found so far." << std::endl;
+	}
+	budget.reset();
+
+	if (improved) {
+		rc = S_OK;
+
+		//only the overall best solution gets into the configuration
+		if ((island_count > 1) && (Write_Parameters(configuration, action.parameters_to_optimize, best_parameters) != S_OK)) {
+			std::wcerr << L"Cannot write the best parameters to the configuration!" << std::endl;
+			rc = E_FAIL;
+		}
+	}
+
+	//the final save supersedes a pending improvement, otherwise it gets saved now; a failed save must fail the whole run
+	if (saver) {
+		const HRESULT save_rc = saver->Finish(rc == S_OK);
+		if (saver->saved_count() > 0)
+			std::wcout << std::endl << L"Improved parameters were saved " << saver->saved_count() << L" times during the optimization." << std::endl;
+		if (!Succeeded(save_rc))
+			rc = save_rc;
+	}
+
+	telemetry.reset();	//writes the final record
+
+	if (stats) {
+		stats->objective_evaluations = objective_evaluations;
+		stats->wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - optimization_start).count();
+	}
+
+	if (console_objective && console_objective->cache) {
+		const CEvaluation_Cache& cache = *console_objective->cache;
+		const size_t lookups = cache.hits() + cache.misses();
+		std::wcout << std::endl << L"Evaluation cache: " << cache.hits() << L" hits, " << cache.misses() << L" misses";
+		if (lookups > 0)
+			std::wcout << L" (" << 100.0 * static_cast<double>(cache.hits()) / static_cast<double>(lookups) << L"% hit rate)";
+		std::wcout << L", " << cache.size() << L" entries." << std::endl;
+
+		if (!action.evaluation_cache_path.empty())
+			cache.Save(action.evaluation_cache_path);
+	}
+
+	//the event logs are held once, however many evaluations replayed them concurrently
+	if (console_objective && !console_objective->event_logs.empty()) {
+		const auto log_stats = Event_Log_Cache_Stats();
+		std::wcout << std::endl << L"Datasets: " << log_stats.log_count << L" event logs, " << static_cast<double>(log_stats.mapped_size) / (1024.0 * 1024.0) << L" MiB mapped once and shared by all the evaluations." << std::endl;
+	}
+	std::wcout << L"Peak memory usage: " << static_cast<double>(Peak_Memory_Usage()) / (1024.0 * 1024.0) << L" MiB" << std::endl;
+
+	if (console_objective && console_objective->archive) {
+		const CPareto_Archive& archive = *console_objective->archive;
+		if (!action.evaluation_log_path.empty())
+			std::wcout << std::endl << L"Logged " << archive.logged_count() << L" evaluations to " << action.evaluation_log_path << L'.' << std::endl;
+
+		if (!action.pareto_front_path.empty() && archive.Write_Front(action.pareto_front_path))
+			std::wcout << std::endl << L"Pareto front of " << archive.front_size() << L" solutions written to " << action.pareto_front_path << L'.' << std::endl;
+	}
+
+	if ((rc == S_OK) && action.discard_result) {
+		std::wcout << L"\nParameters were succesfully optimized, but the result is discarded." << std::endl;
+	}
+	else if (rc == S_OK) {
 		std::wcout << L"\nResulting fitness:";
 		for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
-			std::wcout << L' ' << i << L':' << progress.best_metric[i];
+			std::wcout << L' ' << i << L':' << checkpoint.best_metric[i];
 		}
 
 		std::wcout << L"\nParameters were succesfully optimized, saving...";
-		errors = refcnt::Swstr_list{};
-		rc = configuration->Save_To_File(nullptr, errors.get());
-		errors.for_each([](auto str) { std::wcerr << str << std::endl; });
-		if (!Succeeded(S_OK)) {
-			std::wcerr << std::endl << L"Failed to save optimized parameters!" << std::endl;
+		rc = Save_Configuration(configuration, action.config_path);
+		if (!Succeeded(rc)) {
+			std::wcerr << std::endl << L"Failed to save optimized parameters! Error: " << Describe_Error(rc) << std::endl;
 			return __LINE__;
 		}
 		else
@@ -40,4 +40,11 @@
 #include <scgms/rtl/FilterLib.h>
 #include <scgms/rtl/SolverLib.h>
 
-int Optimize_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const TAction &action, solver::TSolver_Progress& progress);
+struct TOptimization_Stats {
+	size_t objective_evaluations = 0;
+	double wall_time = 0.0;		//seconds spent by the solvers
+};
+
+bool Is_Better_Fitness(const solver::TFitness& candidate, const solver::TFitness& best);	//lexicographic order, NaN is the worst possible fitness
+
+int Optimize_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const TAction &action, solver::TSolver_Progress& progress, TOptimization_Stats* stats = nullptr);
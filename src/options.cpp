@@ -35,6 +35,7 @@
  */
 
 #include "options.h"
+#include "affinity.h"
 
 #include <scgms/rtl/UILib.h>
 #include <scgms/utils/string_utils.h>
@@ -42,6 +43,7 @@
 
 #include <iostream>
 #include <typeinfo>
+#include <algorithm>
 
 using TOption_Index = std::remove_cv<decltype(option::Descriptor::index)>::type;
 enum class NOption_Index : TOption_Index {
@@ -55,7 +57,40 @@ enum class NOption_Index : TOption_Index {
 	population_size,
 	save_config,
 	hint,
-	parameters_hint
+	parameters_hint,
+	worker_count,
+	sweep_range,
+	sweep_output,
+	hint_cache,
+	hint_deduplication,
+	hint_limit,
+	checkpoint,
+	checkpoint_generations,
+	resume,
+	restarts,
+	migration_generations,
+	telemetry,
+	telemetry_interval,
+	warm_config,
+	timeout,
+	max_evaluations,
+	target_fitness,
+	stagnation,
+	save_improvements,
+	evaluation_cache,
+	console_evaluation,
+	evaluation_log,
+	pareto_front,
+	dataset,
+	aggregate,
+	folds,
+	affinity,
+	numa_node,
+	startup_timing,
+	export_path,
+	profile,
+	stdin_events,
+	event_log
 };
 
 
@@ -64,6 +99,10 @@ enum class NAction_Type : TOption_Type {
 	unused = 0,
 	execute_config,
 	optimize_config,
+	batch_config,
+	sweep_config,
+	serve_config,
+	convert_config,
 };
 
 constexpr option::Descriptor Unknown_Option = { static_cast<TOption_Index>(NOption_Index::unknown), static_cast<TOption_Type>(NAction_Type::unused), "", "" , option::Arg::None, "Usage: console3.exe configuration_path [options]\n\n"
@@ -72,6 +111,10 @@ constexpr option::Descriptor Unknown_Option = { static_cast<TOption_Index>(NOpti
 
 constexpr option::Descriptor actExecute = { static_cast<TOption_Index>(NOption_Index::action), static_cast<TOption_Type>(NAction_Type::execute_config), "e" , "execute" ,option::Arg::None, "--execute, -e \t\texecutes the configuratin, exclusive to optimize; default action" };
 constexpr option::Descriptor actOptimize = { static_cast<TOption_Index>(NOption_Index::action), static_cast<TOption_Type>(NAction_Type::optimize_config), "o" , "optimize" ,option::Arg::None, "--optimize, -o \t\tperforms optimization instead of execution" };
+constexpr option::Descriptor actBatch = { static_cast<TOption_Index>(NOption_Index::action), static_cast<TOption_Type>(NAction_Type::batch_config), "b" , "batch" ,option::Arg::None, "--batch, -b \t\ttreats configuration_path as a manifest, whose lines are config_path [-v name:=value]..., and executes them in parallel" };
+constexpr option::Descriptor actSweep = { static_cast<TOption_Index>(NOption_Index::action), static_cast<TOption_Type>(NAction_Type::sweep_config), "" , "sweep" ,option::Arg::None, "--sweep \t\tevaluates the configuration over a grid of parameter values given by --range" };
+constexpr option::Descriptor actServe = { static_cast<TOption_Index>(NOption_Index::action), static_cast<TOption_Type>(NAction_Type::serve_config), "" , "serve" ,option::Arg::None, "--serve \t\ttreats configuration_path as a Unix domain socket, and runs the jobs submitted through it until interrupted" };
+constexpr option::Descriptor actConvert = { static_cast<TOption_Index>(NOption_Index::action), static_cast<TOption_Type>(NAction_Type::convert_config), "" , "convert" ,option::Arg::None, "--convert \t\ttreats configuration_path as a SmartCGMS log, or an event stream, and converts it to the binary event log given by --event_log" };
 constexpr option::Descriptor actSave = { static_cast<TOption_Index>(NOption_Index::save_config), static_cast<TOption_Type>(NAction_Type::unused), "s" , "save_configuration" ,option::Arg::None, "--save_configuration, -s \t\tsaves the config after execution/optimization" };
 constexpr option::Descriptor actSolver_Id = { static_cast<TOption_Index>(NOption_Index::solver_id), static_cast<TOption_Type>(NAction_Type::unused), "r" , "solver_id" ,option::Arg::Optional, "--solver_id, -r={solver-guid} \t\tselects the desired solver" };
 constexpr option::Descriptor actGeneration_Count = { static_cast<TOption_Index>(NOption_Index::generation_count), static_cast<TOption_Type>(NAction_Type::unused), "g" , "generation_count" ,option::Arg::Optional, "--generation_count, -g=sets the maximum number of generations/iterations for the solver" };
@@ -81,20 +124,60 @@ constexpr option::Descriptor actParameter = { static_cast<TOption_Index>(NOption
 constexpr option::Descriptor actVariable = { static_cast<TOption_Index>(NOption_Index::variable), static_cast<TOption_Type>(NAction_Type::unused), "v" , "variable" ,option::Arg::Optional, "--variable, -v=name:=value sets internal variables to possibly complement operating-system variables" };
 constexpr option::Descriptor actHint = { static_cast<TOption_Index>(NOption_Index::hint), static_cast<TOption_Type>(NAction_Type::unused), "h" , "hint" ,option::Arg::Optional, "--hint, -h=file_mask to files containing hints" };
 constexpr option::Descriptor actParameter_Hint = { static_cast<TOption_Index>(NOption_Index::parameters_hint), static_cast<TOption_Type>(NAction_Type::unused), "m" , "parameters_hint" ,option::Arg::Optional, "--parameters_hint, -m=file_mask, but loads single hint from a parameters file" };
+constexpr option::Descriptor actHint_Cache = { static_cast<TOption_Index>(NOption_Index::hint_cache), static_cast<TOption_Type>(NAction_Type::unused), "" , "hint_cache" ,option::Arg::None, "--hint_cache \t\tcaches parsed hints in binary .hintcache files next to the hint files" };
+constexpr option::Descriptor actHint_Deduplication = { static_cast<TOption_Index>(NOption_Index::hint_deduplication), static_cast<TOption_Type>(NAction_Type::unused), "" , "hint_dedup" ,option::Arg::Optional, "--hint_dedup[=epsilon] removes duplicate hints, or hints closer than epsilon relative to the parameter bounds" };
+constexpr option::Descriptor actHint_Limit = { static_cast<TOption_Index>(NOption_Index::hint_limit), static_cast<TOption_Type>(NAction_Type::unused), "" , "hint_limit" ,option::Arg::Optional, "--hint_limit=maximum number of hints, the most diverse ones are kept" };
+constexpr option::Descriptor actEvaluation_Cache = { static_cast<TOption_Index>(NOption_Index::evaluation_cache), static_cast<TOption_Type>(NAction_Type::unused), "" , "evaluation_cache" ,option::Arg::Optional, "--evaluation_cache[=file] remembers the metrics of evaluated parameters, and keeps them in the file across runs" };
+constexpr option::Descriptor actConsole_Evaluation = { static_cast<TOption_Index>(NOption_Index::console_evaluation), static_cast<TOption_Type>(NAction_Type::unused), "" , "console_evaluation" ,option::Arg::None, "--console_evaluation \t\tthe console evaluates the solutions on all the workers, instead of the solver replaying the chain by itself" };
+constexpr option::Descriptor actEvaluation_Log = { static_cast<TOption_Index>(NOption_Index::evaluation_log), static_cast<TOption_Type>(NAction_Type::unused), "" , "evaluation_log" ,option::Arg::Optional, "--evaluation_log=file to append every evaluated parameters, and their metrics, to" };
+constexpr option::Descriptor actPareto_Front = { static_cast<TOption_Index>(NOption_Index::pareto_front), static_cast<TOption_Type>(NAction_Type::unused), "" , "pareto_front" ,option::Arg::Optional, "--pareto_front=file to write the non-dominated solutions of a multi-objective optimization to" };
+constexpr option::Descriptor actDataset = { static_cast<TOption_Index>(NOption_Index::dataset), static_cast<TOption_Type>(NAction_Type::unused), "" , "dataset" ,option::Arg::Optional, "--dataset=name:=value - possibly multiple options of the same variable; each objective evaluation runs the configuration with every value" };
+constexpr option::Descriptor actAggregate = { static_cast<TOption_Index>(NOption_Index::aggregate), static_cast<TOption_Type>(NAction_Type::unused), "" , "aggregate" ,option::Arg::Optional, "--aggregate=mean, max or pNN (e.g., p90 percentile) of the dataset metrics; defaults to mean" };
+constexpr option::Descriptor actFolds = { static_cast<TOption_Index>(NOption_Index::folds), static_cast<TOption_Type>(NAction_Type::unused), "" , "folds" ,option::Arg::Optional, "--folds=k reports the held-out fitness of k-fold cross-validation over the datasets, before optimizing on all of them" };
+constexpr option::Descriptor actCheckpoint = { static_cast<TOption_Index>(NOption_Index::checkpoint), static_cast<TOption_Type>(NAction_Type::unused), "" , "checkpoint" ,option::Arg::Optional, "--checkpoint=file to store the best parameters and the optimization progress to, when the run ends or gets cancelled, and after each migration" };
+constexpr option::Descriptor actCheckpoint_Generations = { static_cast<TOption_Index>(NOption_Index::checkpoint_generations), static_cast<TOption_Type>(NAction_Type::unused), "" , "checkpoint_generations" ,option::Arg::Optional, "--checkpoint_generations=number of generations between two checkpoints; restarts the solver each time, seeded with the best solution, i.e.; discards its population and may change the result" };
+constexpr option::Descriptor actResume = { static_cast<TOption_Index>(NOption_Index::resume), static_cast<TOption_Type>(NAction_Type::unused), "" , "resume" ,option::Arg::Optional, "--resume=checkpoint file to continue the optimization from" };
+constexpr option::Descriptor actRestarts = { static_cast<TOption_Index>(NOption_Index::restarts), static_cast<TOption_Type>(NAction_Type::unused), "" , "restarts" ,option::Arg::Optional, "--restarts=number of concurrent solver instances, which share the population size; multiple --solver_id imply as many instances" };
+constexpr option::Descriptor actMigration_Generations = { static_cast<TOption_Index>(NOption_Index::migration_generations), static_cast<TOption_Type>(NAction_Type::unused), "" , "migration_generations" ,option::Arg::Optional, "--migration_generations=number of generations, after which the solver instances share the best solution" };
+constexpr option::Descriptor actTelemetry = { static_cast<TOption_Index>(NOption_Index::telemetry), static_cast<TOption_Type>(NAction_Type::unused), "" , "telemetry" ,option::Arg::Optional, "--telemetry=file to sample progress, fitness and throughput to; .csv gives CSV, otherwise JSON lines" };
+constexpr option::Descriptor actTelemetry_Interval = { static_cast<TOption_Index>(NOption_Index::telemetry_interval), static_cast<TOption_Type>(NAction_Type::unused), "" , "telemetry_interval" ,option::Arg::Optional, "--telemetry_interval=milliseconds between two telemetry samples" };
+constexpr option::Descriptor actTimeout = { static_cast<TOption_Index>(NOption_Index::timeout), static_cast<TOption_Type>(NAction_Type::unused), "" , "timeout" ,option::Arg::Optional, "--timeout=seconds, after which the execution or optimization is cancelled; the optimization keeps its best solution" };
+constexpr option::Descriptor actMax_Evaluations = { static_cast<TOption_Index>(NOption_Index::max_evaluations), static_cast<TOption_Type>(NAction_Type::unused), "" , "max_evaluations" ,option::Arg::Optional, "--max_evaluations=number of evaluated solutions, not counting those found in the evaluation cache, after which the optimization is cancelled and keeps its best solution" };
+constexpr option::Descriptor actTarget_Fitness = { static_cast<TOption_Index>(NOption_Index::target_fitness), static_cast<TOption_Type>(NAction_Type::unused), "" , "target_fitness" ,option::Arg::Optional, "--target_fitness=objective_zero_index,value - possibly multiple options; the optimization stops, once all the objectives reach their values" };
+constexpr option::Descriptor actStagnation = { static_cast<TOption_Index>(NOption_Index::stagnation), static_cast<TOption_Type>(NAction_Type::unused), "" , "stagnation" ,option::Arg::Optional, "--stagnation=generations, or seconds with the s suffix, without improvement, after which the optimization stops" };
+constexpr option::Descriptor actSave_Improvements = { static_cast<TOption_Index>(NOption_Index::save_improvements), static_cast<TOption_Type>(NAction_Type::unused), "" , "save_improvements" ,option::Arg::Optional, "--save_improvements[=seconds] saves the best parameters into the configuration whenever they improve, at most once per the period; the console then evaluates the solutions instead of the solver" };
+constexpr option::Descriptor actWorker_Count = { static_cast<TOption_Index>(NOption_Index::worker_count), static_cast<TOption_Type>(NAction_Type::unused), "w" , "workers" ,option::Arg::Optional, "--workers, -w=maximum number of concurrently executed batch or served jobs, and of the worker threads shared by all the evaluations; defaults to the number of CPU cores" };
+constexpr option::Descriptor actThreads = { static_cast<TOption_Index>(NOption_Index::worker_count), static_cast<TOption_Type>(NAction_Type::unused), "" , "threads" ,option::Arg::Optional, "--threads=the same as --workers" };
+constexpr option::Descriptor actAffinity = { static_cast<TOption_Index>(NOption_Index::affinity), static_cast<TOption_Type>(NAction_Type::unused), "" , "affinity" ,option::Arg::Optional, "--affinity=compact, scatter, or a list of CPUs like 0,2,4-7, to pin the worker threads to" };
+constexpr option::Descriptor actNUMA_Node = { static_cast<TOption_Index>(NOption_Index::numa_node), static_cast<TOption_Type>(NAction_Type::unused), "" , "numa_node" ,option::Arg::Optional, "--numa_node=zero-based index of the NUMA node, to which all the threads of the process are restricted" };
+constexpr option::Descriptor actStartup_Timing = { static_cast<TOption_Index>(NOption_Index::startup_timing), static_cast<TOption_Type>(NAction_Type::unused), "" , "startup_timing" ,option::Arg::None, "--startup_timing reports the time spent loading the libraries, initializing Qt, parsing the options and the configuration, and constructing the executor" };
+constexpr option::Descriptor actSweep_Range = { static_cast<TOption_Index>(NOption_Index::sweep_range), static_cast<TOption_Type>(NAction_Type::unused), "" , "range" ,option::Arg::Optional, "--range=filter_zero_index,parameter_name,element_zero_index,min,max,steps - possibly multiple options gives the sweep grid" };
+constexpr option::Descriptor actSweep_Output = { static_cast<TOption_Index>(NOption_Index::sweep_output), static_cast<TOption_Type>(NAction_Type::unused), "" , "sweep_output" ,option::Arg::Optional, "--sweep_output=file to write the sweep results to, instead of the standard output" };
+constexpr option::Descriptor actWarm_Config = { static_cast<TOption_Index>(NOption_Index::warm_config), static_cast<TOption_Type>(NAction_Type::unused), "" , "warm_config" ,option::Arg::None, "--warm_config \t\tbatch reads and resolves each configuration once, and instantiates it from memory for every job" };
+constexpr option::Descriptor actExport = { static_cast<TOption_Index>(NOption_Index::export_path), static_cast<TOption_Type>(NAction_Type::unused), "" , "export" ,option::Arg::Optional, "--export=file to write the level events leaving the executed chain to, in a compressed columnar binary format" };
+constexpr option::Descriptor actProfile = { static_cast<TOption_Index>(NOption_Index::profile), static_cast<TOption_Type>(NAction_Type::unused), "" , "profile" ,option::Arg::Optional, "--profile[=trace.json] to report the events/s, the mean and p99 latency and the queue depth of each filter of the executed chain, optionally with a Chrome trace-event file" };
+constexpr option::Descriptor actStdin_Events = { static_cast<TOption_Index>(NOption_Index::stdin_events), static_cast<TOption_Type>(NAction_Type::unused), "" , "stdin_events" ,option::Arg::None, "--stdin_events injects the events read from the standard input, as lines of segment signal time level, or in the binary event stream format, into the executed chain" };
+constexpr option::Descriptor actEvent_Log = { static_cast<TOption_Index>(NOption_Index::event_log), static_cast<TOption_Type>(NAction_Type::unused), "" , "event_log" ,option::Arg::Optional, "--event_log=file of the binary event log, which execution and optimization replay in place of the first filter of the chain, i.e.; its input, or which --convert writes; $(variable) of --dataset selects a log per dataset" };
 constexpr option::Descriptor Zero_Terminating_Option = { static_cast<TOption_Index>(NOption_Index::invalid), static_cast<TOption_Type>(NAction_Type::unused), nullptr , nullptr ,option::Arg::None, nullptr };
 
-constexpr std::array<option::Descriptor, 12> option_syntax{ Unknown_Option, actExecute, actOptimize, actSave, actSolver_Id, actGeneration_Count, actPopulation_Size, actParameter, actVariable, actHint, actParameter_Hint, Zero_Terminating_Option };
+constexpr std::array<option::Descriptor, 50> option_syntax{ Unknown_Option, actExecute, actOptimize, actBatch, actSweep, actServe, actConvert, actSave, actSolver_Id, actGeneration_Count, actPopulation_Size, actParameter, actVariable, actHint, actParameter_Hint, actHint_Cache, actHint_Deduplication, actHint_Limit, actEvaluation_Cache, actConsole_Evaluation, actEvaluation_Log, actPareto_Front, actDataset, actAggregate, actFolds, actCheckpoint, actCheckpoint_Generations, actResume, actRestarts, actMigration_Generations, actTarget_Fitness, actStagnation, actSave_Improvements, actTelemetry, actTelemetry_Interval, actTimeout, actMax_Evaluations, actWorker_Count, actThreads, actAffinity, actNUMA_Node, actStartup_Timing, actSweep_Range, actSweep_Output, actWarm_Config, actExport, actProfile, actStdin_Events, actEvent_Log, Zero_Terminating_Option };
+
+//enumerated on the first use only, i.e.; for the help, or a malformed solver id, as the enumeration walks all the loaded solver libraries
+const std::vector<scgms::TSolver_Descriptor>& Solver_Descriptors() {
+	static const std::vector<scgms::TSolver_Descriptor> descriptors = scgms::get_solver_descriptor_list();
+	return descriptors;
+}
 
 void Show_Help() {
 	option::printUsage(std::cout, option_syntax.data());    
 
-    const auto all_desc = scgms::get_solver_descriptor_list();
+    const auto& all_desc = Solver_Descriptors();
     if (all_desc.empty()) {
         std::wcout << L"Warning! There's no solver descriptor actually available!" << std::endl;
     }
     else {
         std::wcout << std::endl << L"Available solvers:" << std::endl;
-        for (const auto& solver : scgms::get_solver_descriptor_list())
+        for (const auto& solver : all_desc)
             if (!solver.specialized)
                 std::wcout << GUID_To_WString(solver.id) << " - " << solver.description << std::endl;
     }
@@ -114,6 +197,79 @@ std::vector<std::wstring> Gather_Values(const NOption_Index idx, std::vector<opt
 	return result;
 }
 
+bool Parse_Variable(const std::wstring& var_str, TVariable& variable) {
+	const auto delim_pos = var_str.find(L":=");
+	if (delim_pos == std::wstring::npos)
+		return false;
+
+	variable.name = var_str.substr(0, delim_pos);
+	variable.value = var_str.substr(delim_pos + 2);
+
+	return !variable.name.empty() && !variable.value.empty();
+}
+
+bool Parse_Sweep_Range(const std::wstring& range_str, std::vector<TOptimize_Parameter>& parameters) {
+	std::vector<std::wstring> fields;
+	size_t field_begin = 0;
+	for (size_t delim_pos = range_str.find(L','); delim_pos != std::wstring::npos; delim_pos = range_str.find(L',', field_begin)) {
+		fields.push_back(range_str.substr(field_begin, delim_pos - field_begin));
+		field_begin = delim_pos + 1;
+	}
+	fields.push_back(range_str.substr(field_begin));
+
+	if ((fields.size() != 6) || fields[1].empty())
+		return false;
+
+	bool index_ok = false, element_ok = false, lower_ok = false, upper_ok = false, steps_ok = false;
+	const auto index = str_2_int(fields[0].c_str(), index_ok);
+	const auto element = str_2_int(fields[2].c_str(), element_ok);
+	const auto steps = str_2_int(fields[5].c_str(), steps_ok);
+
+	TSweep_Range range;
+	range.lower = str_2_dbl(fields[3].c_str(), lower_ok);
+	range.upper = str_2_dbl(fields[4].c_str(), upper_ok);
+
+	if (!index_ok || (index < 0) || !element_ok || (element < 0) || !lower_ok || !upper_ok || !steps_ok || (steps < 1))
+		return false;
+
+	range.element = static_cast<size_t>(element);
+	range.steps = static_cast<size_t>(steps);
+
+	//ranges of the same filter parameter share a single parameter to optimize
+	auto param = std::find_if(parameters.begin(), parameters.end(), [&](const TOptimize_Parameter& known) {
+		return (known.index == static_cast<size_t>(index)) && (known.name == fields[1]);
+	});
+
+	if (param == parameters.end()) {
+		TOptimize_Parameter param_desc;
+		param_desc.index = static_cast<size_t>(index);
+		param_desc.name = fields[1];
+		param = parameters.insert(parameters.end(), param_desc);
+	}
+
+	param->sweep_ranges.push_back(range);
+	return true;
+}
+
+bool Parse_Target_Fitness(const std::wstring& target_str, std::vector<TTarget_Fitness>& targets) {
+	const auto delim_pos = target_str.find(L',');
+	if (delim_pos == std::wstring::npos)
+		return false;
+
+	bool objective_ok = false, value_ok = false;
+	const auto objective = str_2_int(target_str.substr(0, delim_pos).c_str(), objective_ok);
+
+	TTarget_Fitness target;
+	target.value = str_2_dbl(target_str.substr(delim_pos + 1).c_str(), value_ok);
+
+	if (!objective_ok || (objective < 0) || (static_cast<size_t>(objective) >= solver::Maximum_Objectives_Count) || !value_ok)
+		return false;
+
+	target.objective = static_cast<size_t>(objective);
+	targets.push_back(target);
+	return true;
+}
+
 TAction Resolve_Parameters(TAction &known_config, std::vector<option::Option>& options) {
 	TAction result = known_config;    
 
@@ -121,16 +277,117 @@ TAction Resolve_Parameters(TAction &known_config, std::vector<option::Option>& o
 	const auto& save_config_arg = options[static_cast<size_t>(NOption_Index::save_config)];
 	result.save_config = static_cast<bool>(save_config_arg);
 
+	//1.1 variables, can be empty
+	std::vector<std::wstring> vars = Gather_Values(NOption_Index::variable, options);
+	for (const auto& var_str : vars) {
+		TVariable var_to_set;
+		if (!Parse_Variable(var_str, var_to_set)) {
+			std::wcerr << L"Malformed variable parameter: " << var_str << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+
+		result.variables.push_back(var_to_set);
+	}
+
+	//1.2 worker count
+	const auto& worker_count_arg = options[static_cast<size_t>(NOption_Index::worker_count)];
+	if (worker_count_arg) {
+		bool ok = false;
+		const size_t worker_count = str_2_uint(worker_count_arg.arg, ok);
+		if (ok && (worker_count > 0))
+			result.worker_count = worker_count;
+		else {
+			std::wcerr << L"Cannot resolve worker count to a positive number!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+	}
+
+	//1.3 telemetry
+	const auto& telemetry_arg = options[static_cast<size_t>(NOption_Index::telemetry)];
+	if (telemetry_arg && telemetry_arg.arg)
+		result.telemetry_path = Widen_Char(telemetry_arg.arg);
+
+	const auto& telemetry_interval_arg = options[static_cast<size_t>(NOption_Index::telemetry_interval)];
+	if (telemetry_interval_arg) {
+		bool ok = false;
+		result.telemetry_interval = str_2_uint(telemetry_interval_arg.arg, ok);
+		if (!ok || (result.telemetry_interval == 0)) {
+			std::wcerr << L"Cannot resolve telemetry interval to a positive number of milliseconds!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+	}
+
+	//1.4 budgets
+	const auto& timeout_arg = options[static_cast<size_t>(NOption_Index::timeout)];
+	if (timeout_arg) {
+		bool ok = false;
+		result.timeout = str_2_dbl(Widen_Char(timeout_arg.arg).c_str(), ok);
+		if (!ok || (result.timeout <= 0.0)) {
+			std::wcerr << L"Cannot resolve timeout to a positive number of seconds!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+	}
+
+	const auto& max_evaluations_arg = options[static_cast<size_t>(NOption_Index::max_evaluations)];
+	if (max_evaluations_arg) {
+		bool ok = false;
+		result.max_evaluations = str_2_uint(max_evaluations_arg.arg, ok);
+		if (!ok || (result.max_evaluations == 0)) {
+			std::wcerr << L"Cannot resolve maximum evaluations to a positive number!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+	}
+
+	//1.5 thread placement
+	const auto& affinity_arg = options[static_cast<size_t>(NOption_Index::affinity)];
+	if (affinity_arg) {
+		const std::string affinity_str = affinity_arg.arg ? affinity_arg.arg : "";
+		if (affinity_str == "compact")
+			result.affinity = NAffinity::compact;
+		else if (affinity_str == "scatter")
+			result.affinity = NAffinity::scatter;
+		else if (Parse_CPU_List(affinity_str, result.affinity_cpus))
+			result.affinity = NAffinity::list;
+		else {
+			std::wcerr << L"Cannot resolve the affinity, expected compact, scatter or a list of CPUs!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+	}
+
+	const auto& numa_node_arg = options[static_cast<size_t>(NOption_Index::numa_node)];
+	if (numa_node_arg) {
+		bool ok = false;
+		result.numa_node = str_2_uint(numa_node_arg.arg, ok);
+		if (!ok) {
+			std::wcerr << L"Cannot resolve the NUMA node to a non-negative number!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+	}
+
+	//1.6 diagnostics
+	result.startup_timing = static_cast<bool>(options[static_cast<size_t>(NOption_Index::startup_timing)]);
+
+	//1.7 event log
+	const auto& event_log_arg = options[static_cast<size_t>(NOption_Index::event_log)];
+	if (event_log_arg && event_log_arg.arg)
+		result.event_log_path = Widen_Char(event_log_arg.arg);
+
     //2. parameters applicable for optimization
     if (result.action == NAction::optimize) {
-        //2.1 let's try to check preferred solver        
-        const auto& solver_id_arg = options[static_cast<size_t>(NOption_Index::solver_id)];
-        if (solver_id_arg) {
+        //2.1 let's try to check preferred solvers, each one runs its own instance
+        for (option::Option* solver_id_arg = options[static_cast<size_t>(NOption_Index::solver_id)]; solver_id_arg; solver_id_arg = solver_id_arg->next()) {
             bool ok = false;
-            const GUID solver_id = WString_To_GUID(Widen_Char(solver_id_arg.arg), ok);
+            const GUID solver_id = WString_To_GUID(Widen_Char(solver_id_arg->arg), ok);
             if (!ok) {
                 std::wcerr << L"Malformed solver id!" << std::endl;
-                const auto all_desc = scgms::get_solver_descriptor_list();
+                const auto& all_desc = Solver_Descriptors();
                 if (all_desc.empty()) {
                     std::wcout << L"Warning! There's no solver descriptor currently available!" << std::endl;
                 }
@@ -142,16 +399,19 @@ TAction Resolve_Parameters(TAction &known_config, std::vector<option::Option>& o
 				return result;
 			}
 			else 
-				result.solver_id = solver_id;
+				result.solver_ids.push_back(solver_id);
 		}
-		else
+
+		if (result.solver_ids.empty())
 			std::wcout << "Solver ID not set, will use the default one. ";
+		else
+			result.solver_id = result.solver_ids[0];
 
 		// solver descriptor scope
-		{
-			//id looks good, let's try to resolve it    
+		for (const GUID& solver_id : result.solver_ids.empty() ? std::vector<GUID>{ result.solver_id } : result.solver_ids) {
+			//id looks good, let's try to resolve it, without enumerating all the solvers
 			scgms::TSolver_Descriptor solver_desc = scgms::Null_Solver_Descriptor;
-			const bool ok = scgms::get_solver_descriptor_by_id(result.solver_id, solver_desc);
+			const bool ok = scgms::get_solver_descriptor_by_id(solver_id, solver_desc);
 			if (!ok) {
 				std::wcerr << L"Cannot resolve the solver id to a known solver descriptor!" << std::endl;
 				result.action = NAction::failed_configuration;
@@ -226,36 +486,266 @@ TAction Resolve_Parameters(TAction &known_config, std::vector<option::Option>& o
 			}
 		}
 
-		//2.5 gather variables to optimize, can be empty
-		std::vector<std::wstring> vars = Gather_Values(NOption_Index::variable, options);
-		for (auto& var_str : vars) {
-			
-			bool resolved_ok = false;
-			const auto delim_pos = var_str.find(L":=");
-			if (delim_pos != std::wstring::npos) {
-				var_str[delim_pos] = 0;
+		//2.5 gather hints for the optimization
+		result.hints_to_load = Gather_Values(NOption_Index::hint, options);
 
-				TVariable var_to_set;
-				var_to_set.name = var_str.c_str();;
-				var_to_set.value = var_str.data() + delim_pos + 2;
+		//2.6 gather hints for the optimization from parameters file
+		result.hinting_parameters_to_load = Gather_Values(NOption_Index::parameters_hint, options);
+		result.hint_cache = static_cast<bool>(options[static_cast<size_t>(NOption_Index::hint_cache)]);
+
+		//2.7 hint reduction
+		const auto& hint_deduplication_arg = options[static_cast<size_t>(NOption_Index::hint_deduplication)];
+		if (hint_deduplication_arg) {
+			result.hint_deduplication = true;
+
+			if (hint_deduplication_arg.arg && (*hint_deduplication_arg.arg != 0)) {
+				bool ok = false;
+				result.hint_epsilon = str_2_dbl(Widen_Char(hint_deduplication_arg.arg).c_str(), ok);
+				if (!ok || (result.hint_epsilon < 0.0)) {
+					std::wcerr << L"Cannot resolve hint deduplication epsilon to a non-negative number!" << std::endl;
+					result.action = NAction::failed_configuration;
+					return result;
+				}
+			}
+		}
 
-				resolved_ok = !var_to_set.name.empty() && var_to_set.value.empty();
-				if (resolved_ok)
-					result.variables.push_back(var_to_set);
+		const auto& hint_limit_arg = options[static_cast<size_t>(NOption_Index::hint_limit)];
+		if (hint_limit_arg) {
+			bool ok = false;
+			result.hint_limit = str_2_uint(hint_limit_arg.arg, ok);
+			if (!ok) {
+				std::wcerr << L"Cannot resolve hint limit to a non-negative number!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
 			}
+		}
 
-			if (!resolved_ok) {
-				std::wcerr << L"Malformed variable parameter: " << var_str << std::endl;
+		//2.7.1 evaluation cache
+		const auto& evaluation_cache_arg = options[static_cast<size_t>(NOption_Index::evaluation_cache)];
+		if (evaluation_cache_arg) {
+			result.evaluation_cache = true;
+			if (evaluation_cache_arg.arg && (*evaluation_cache_arg.arg != 0))
+				result.evaluation_cache_path = Widen_Char(evaluation_cache_arg.arg);
+		}
+
+		if (options[static_cast<size_t>(NOption_Index::console_evaluation)])
+			result.console_evaluation = true;
+
+		//2.7.2 evaluation log and Pareto front
+		const auto& evaluation_log_arg = options[static_cast<size_t>(NOption_Index::evaluation_log)];
+		if (evaluation_log_arg && evaluation_log_arg.arg)
+			result.evaluation_log_path = Widen_Char(evaluation_log_arg.arg);
+
+		const auto& pareto_front_arg = options[static_cast<size_t>(NOption_Index::pareto_front)];
+		if (pareto_front_arg && pareto_front_arg.arg)
+			result.pareto_front_path = Widen_Char(pareto_front_arg.arg);
+
+		//2.7.3 datasets
+		const std::vector<std::wstring> datasets = Gather_Values(NOption_Index::dataset, options);
+		for (const auto& dataset_str : datasets) {
+			TVariable dataset;
+			if (!Parse_Variable(dataset_str, dataset) || (!result.dataset_variable.empty() && (result.dataset_variable != dataset.name))) {
+				std::wcerr << L"Malformed dataset, or a dataset of another variable: " << dataset_str << std::endl;
 				result.action = NAction::failed_configuration;
 				return result;
 			}
+
+			result.dataset_variable = dataset.name;
+			result.datasets.push_back(dataset.value);
 		}
 
-		//2.6 gather hints for the optimization
-		result.hints_to_load = Gather_Values(NOption_Index::hint, options);
+		//a single event log would make all the datasets replay the very same events
+		if ((result.datasets.size() > 1) && !result.event_log_path.empty() && (result.event_log_path.find(L"$(" + result.dataset_variable + L")") == std::wstring::npos)) {
+			std::wcerr << L"The event log must refer to $(" << result.dataset_variable << L") to select a log per dataset: " << result.event_log_path << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
 
-		//2.7 gather hints for the optimization from parameters file
-		result.hinting_parameters_to_load = Gather_Values(NOption_Index::parameters_hint, options);
+		const auto& aggregate_arg = options[static_cast<size_t>(NOption_Index::aggregate)];
+		if (aggregate_arg) {
+			const std::string aggregate_str = aggregate_arg.arg ? aggregate_arg.arg : "";
+			bool ok = true;
+			if (aggregate_str == "mean")
+				result.aggregation = NMetric_Aggregation::mean;
+			else if (aggregate_str == "max")
+				result.aggregation = NMetric_Aggregation::max;
+			else if ((aggregate_str.size() > 1) && (aggregate_str[0] == 'p')) {
+				result.aggregation = NMetric_Aggregation::percentile;
+				result.aggregation_percentile = str_2_dbl(Widen_Char(aggregate_str.c_str() + 1).c_str(), ok);
+				ok &= (result.aggregation_percentile >= 0.0) && (result.aggregation_percentile <= 100.0);
+			}
+			else
+				ok = false;
+
+			if (!ok) {
+				std::wcerr << L"Cannot resolve the metric aggregation, expected mean, max or pNN!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		const auto& folds_arg = options[static_cast<size_t>(NOption_Index::folds)];
+		if (folds_arg) {
+			bool ok = false;
+			result.folds = str_2_uint(folds_arg.arg, ok);
+			if (!ok || (result.folds < 2) || (result.folds > result.datasets.size())) {
+				std::wcerr << L"Cannot resolve folds to a number between 2 and the number of datasets!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		//2.8 checkpoints
+		const auto& checkpoint_arg = options[static_cast<size_t>(NOption_Index::checkpoint)];
+		if (checkpoint_arg && checkpoint_arg.arg)
+			result.checkpoint_path = Widen_Char(checkpoint_arg.arg);
+
+		const auto& checkpoint_generations_arg = options[static_cast<size_t>(NOption_Index::checkpoint_generations)];
+		if (checkpoint_generations_arg) {
+			bool ok = false;
+			result.checkpoint_generations = str_2_uint(checkpoint_generations_arg.arg, ok);
+			if (!ok || (result.checkpoint_generations == 0)) {
+				std::wcerr << L"Cannot resolve checkpoint generations to a positive number!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+
+			if (result.checkpoint_path.empty()) {
+				std::wcerr << L"Checkpoint generations need a checkpoint file!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		const auto& resume_arg = options[static_cast<size_t>(NOption_Index::resume)];
+		if (resume_arg && resume_arg.arg)
+			result.resume_path = Widen_Char(resume_arg.arg);
+
+		//2.9 multi-start
+		const auto& restarts_arg = options[static_cast<size_t>(NOption_Index::restarts)];
+		if (restarts_arg) {
+			bool ok = false;
+			result.restarts = str_2_uint(restarts_arg.arg, ok);
+			if (!ok || (result.restarts == 0)) {
+				std::wcerr << L"Cannot resolve restarts to a positive number!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		const auto& migration_generations_arg = options[static_cast<size_t>(NOption_Index::migration_generations)];
+		if (migration_generations_arg) {
+			bool ok = false;
+			result.migration_generations = str_2_uint(migration_generations_arg.arg, ok);
+			if (!ok || (result.migration_generations == 0)) {
+				std::wcerr << L"Cannot resolve migration generations to a positive number!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		//2.10 early stopping
+		const std::vector<std::wstring> targets = Gather_Values(NOption_Index::target_fitness, options);
+		for (const auto& target_str : targets) {
+			if (!Parse_Target_Fitness(target_str, result.target_fitness)) {
+				std::wcerr << L"Malformed target fitness: " << target_str << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		const auto& stagnation_arg = options[static_cast<size_t>(NOption_Index::stagnation)];
+		if (stagnation_arg) {
+			std::string stagnation_str = stagnation_arg.arg ? stagnation_arg.arg : "";
+			const bool in_seconds = !stagnation_str.empty() && (stagnation_str.back() == 's');
+			if (in_seconds)
+				stagnation_str.pop_back();
+
+			bool ok = false;
+			if (in_seconds) {
+				result.stagnation_seconds = str_2_dbl(Widen_Char(stagnation_str.c_str()).c_str(), ok);
+				ok &= result.stagnation_seconds > 0.0;
+			}
+			else {
+				result.stagnation_generations = str_2_uint(stagnation_str.c_str(), ok);
+				ok &= result.stagnation_generations > 0;
+			}
+
+			if (!ok) {
+				std::wcerr << L"Cannot resolve stagnation to a positive number of generations, or seconds!" << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		//2.11 saving on improvement
+		const auto& save_improvements_arg = options[static_cast<size_t>(NOption_Index::save_improvements)];
+		if (save_improvements_arg) {
+			result.save_improvements = true;
+			if (save_improvements_arg.arg && (*save_improvements_arg.arg != 0)) {
+				bool ok = false;
+				result.save_improvements_period = str_2_dbl(Widen_Char(save_improvements_arg.arg).c_str(), ok);
+				if (!ok || (result.save_improvements_period < 0.0)) {
+					std::wcerr << L"Cannot resolve the period of saving improvements to a non-negative number of seconds!" << std::endl;
+					result.action = NAction::failed_configuration;
+					return result;
+				}
+			}
+		}
+	}
+
+	//3. parameters applicable for sweep
+	if (result.action == NAction::sweep) {
+		//3.1 gather the grid, must have at least one range
+		const std::vector<std::wstring> ranges = Gather_Values(NOption_Index::sweep_range, options);
+		for (const auto& range_str : ranges) {
+			if (!Parse_Sweep_Range(range_str, result.parameters_to_optimize)) {
+				std::wcerr << L"Malformed sweep range: " << range_str << std::endl;
+				result.action = NAction::failed_configuration;
+				return result;
+			}
+		}
+
+		if (result.parameters_to_optimize.empty()) {
+			std::wcerr << L"Sweep requires at least one --range!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+
+		//3.2 output file, optional
+		const auto& sweep_output_arg = options[static_cast<size_t>(NOption_Index::sweep_output)];
+		if (sweep_output_arg && sweep_output_arg.arg)
+			result.sweep_output = Widen_Char(sweep_output_arg.arg);
+	}
+
+	//4. parameters applicable for batch
+	if (result.action == NAction::batch)
+		result.warm_config = static_cast<bool>(options[static_cast<size_t>(NOption_Index::warm_config)]);
+
+	//5. parameters applicable for execution
+	if (result.action == NAction::execute) {
+		const auto& export_arg = options[static_cast<size_t>(NOption_Index::export_path)];
+		if (export_arg && export_arg.arg)
+			result.export_path = Widen_Char(export_arg.arg);
+
+		const auto& profile_arg = options[static_cast<size_t>(NOption_Index::profile)];
+		result.profile = static_cast<bool>(profile_arg);
+		if (profile_arg && profile_arg.arg)
+			result.profile_trace_path = Widen_Char(profile_arg.arg);
+
+		result.stdin_events = static_cast<bool>(options[static_cast<size_t>(NOption_Index::stdin_events)]);
+		if (result.stdin_events && !result.event_log_path.empty()) {
+			std::wcerr << L"The chain can get its events either from the standard input, or from the event log, but not both!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
+
+		//the profiled chain is built by the console, which has no executor to inject the events into
+		if (result.profile && (result.stdin_events || !result.event_log_path.empty())) {
+			std::wcerr << L"The profiled chain must read its events on its own, not from the standard input, nor from the event log!" << std::endl;
+			result.action = NAction::failed_configuration;
+			return result;
+		}
 	}
 
 	return result;
@@ -309,12 +799,32 @@ TAction Parse_Options(const int argc, const char** argv) {
 				result.action = NAction::execute;
 				break;
 
+			case static_cast<TOption_Type>(NAction_Type::batch_config):
+				result.action = NAction::batch;
+				break;
+
+			case static_cast<TOption_Type>(NAction_Type::sweep_config):
+				result.action = NAction::sweep;
+				break;
+
+			case static_cast<TOption_Type>(NAction_Type::serve_config):
+				result.action = NAction::serve;
+				break;
+
+			case static_cast<TOption_Type>(NAction_Type::convert_config):
+				result.action = NAction::convert;
+				break;
+
 			default:
 				result.action = NAction::failed_configuration;
 				std::wcerr << L"Unknown action code: " << static_cast<size_t>(action_type) << std::endl;
 
 				std::cout << actExecute.help << std::endl;
 				std::cout << actOptimize.help << std::endl;
+				std::cout << actBatch.help << std::endl;
+				std::cout << actSweep.help << std::endl;
+				std::cout << actServe.help << std::endl;
+				std::cout << actConvert.help << std::endl;
 				break;
 		}
 	}
@@ -45,12 +45,41 @@
 enum class NAction : size_t {
 	failed_configuration,
 	execute,
-	optimize
+	optimize,
+	batch,
+	sweep,
+	serve,
+	convert
+};
+
+struct TSweep_Range {
+	size_t element = 0;										// zero-based index within the parameters vector
+	double lower = 0.0, upper = 0.0;
+	size_t steps = 1;										// number of grid points, including both bounds
 };
 
 struct TOptimize_Parameter {
 	size_t index = std::numeric_limits<size_t>::max();
 	std::wstring name;
+	std::vector<TSweep_Range> sweep_ranges;
+};
+
+enum class NAffinity : size_t {
+	none,													// the operating system places the threads
+	compact,												// fill the CPUs of one NUMA node, before the next one
+	scatter,												// round-robin over the NUMA nodes
+	list													// the given CPUs, in the given order
+};
+
+enum class NMetric_Aggregation : size_t {
+	mean,
+	max,
+	percentile
+};
+
+struct TTarget_Fitness {
+	size_t objective = 0;									// zero-based index into the best metric
+	double value = 0.0;										// reached, once the metric is less or equal
 };
 
 struct TVariable {
@@ -62,16 +91,66 @@ struct TAction {
 
 	std::wstring config_path;
 	bool save_config = false;
+	bool discard_result = false;							// optimization does not save the configuration, e.g., when benchmarking
 	GUID solver_id = { 0x1274b08, 0xf721, 0x42bc, { 0xa5, 0x62, 0x5, 0x56, 0x71, 0x4c, 0x56, 0x85 } };	// Halton MetaDE
 	size_t generation_count = 96;							// number of CPU cores divisible by 4, 8 and 16 and 32
 	size_t population_size = 1000;
+	std::vector<GUID> solver_ids;							// all the requested solvers, solver_id holds the first one
+	size_t restarts = 1;									// number of concurrent solver instances
+	size_t migration_generations = 8;						// generations between sharing the best solution among the instances
+	size_t worker_count = 0;								// zero means as many workers as there are CPU cores
+	NAffinity affinity = NAffinity::none;					// placement of the worker threads
+	std::vector<size_t> affinity_cpus;						// CPUs of NAffinity::list
+	size_t numa_node = std::numeric_limits<size_t>::max();	// restricts the whole process to this NUMA node, max means any node
+	bool startup_timing = false;							// reports the duration of the startup phases
+	bool warm_config = false;								// batch instantiates each configuration from an in-memory image
+	double timeout = 0.0;									// seconds of a single execution or optimization, zero means no limit
+	size_t max_evaluations = 0;								// objective evaluations of a single optimization, zero means no limit
+	std::vector<TTarget_Fitness> target_fitness;			// optimization stops, once all of them are reached
+	size_t stagnation_generations = 0;						// optimization stops after this many generations without improvement, zero means never
+	double stagnation_seconds = 0.0;						// optimization stops after this long without improvement, zero means never
+	bool save_improvements = false;							// saves the best parameters, whenever they improve, during the optimization
+	double save_improvements_period = 60.0;					// seconds between two saves of the improved parameters
 
 	std::vector<TOptimize_Parameter> parameters_to_optimize;
 	std::vector<TVariable> variables;
 	
 	std::vector<std::wstring> hints_to_load;				// may include wildcard
 	std::vector<std::wstring> hinting_parameters_to_load;	// may include wildcard
+	bool hint_cache = false;								// store parsed hints to, and load them from .hintcache files
+	bool hint_deduplication = false;
+	double hint_epsilon = 0.0;								// hints closer than this, in bounds-normalized space, are duplicates
+	size_t hint_limit = 0;									// zero means no limit
+
+	bool evaluation_cache = false;							// the console evaluates the solutions and remembers their metrics
+	bool console_evaluation = false;						// the console evaluates the solutions, even without a cache or a log
+	std::wstring evaluation_cache_path;						// empty keeps the evaluation cache in memory only
+	std::wstring evaluation_log_path;						// append-only file of all the evaluations, empty means none
+	std::wstring pareto_front_path;							// non-dominated solutions found, empty means none
+
+	std::wstring dataset_variable;							// variable, which selects the input dataset
+	std::vector<std::wstring> datasets;						// every evaluation runs all of them, and aggregates their metrics
+	NMetric_Aggregation aggregation = NMetric_Aggregation::mean;
+	double aggregation_percentile = 50.0;
+	size_t folds = 0;										// k-fold cross-validation over the datasets, zero or one means none
+
+	std::wstring checkpoint_path;							// empty means no checkpoints
+	size_t checkpoint_generations = 0;						// generations between two checkpoints, each restarting the solver; zero does not restart it
+	std::wstring resume_path;								// checkpoint to continue from
+
+	std::wstring telemetry_path;							// empty means no telemetry
+	size_t telemetry_interval = 1000;						// milliseconds between two telemetry samples
+
+	std::wstring sweep_output;								// empty means standard output
+
+	std::wstring export_path;								// columnar file of the level events leaving the executed chain, empty means none
+	bool profile = false;									// reports the events/s, the latency and the queue depth of each filter of the executed chain
+	std::wstring profile_trace_path;						// Chrome trace-event file of the profile, empty means none
+	bool stdin_events = false;								// the executed chain gets its events from the standard input
+	std::wstring event_log_path;							// binary event log to replay in place of the first filter of the chain, or to convert to
 };
 
 TAction Parse_Options(const int argc, const char** argv);
 void Show_Help();
+
+bool Parse_Variable(const std::wstring& var_str, TVariable& variable);	//parses name:=value
@@ -0,0 +1,182 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "pareto.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+struct TEvaluation_Log_Header {
+	char magic[8] = { 'S', 'C', 'G', 'M', 'S', 'E', 'L', 0 };
+	uint32_t version = 1;
+	uint32_t reserved = 0;
+	uint64_t problem_size = 0;
+	uint64_t metrics_count = 0;
+	//problem_size parameters and metrics_count metrics per record follow until the end of the file
+};
+
+//weak dominance, so that a duplicate never enters the front
+bool Dominates_Or_Equals(const std::vector<double>& a, const std::vector<double>& b) {
+	for (size_t i = 0; i < a.size(); i++)
+		if (a[i] > b[i])
+			return false;
+
+	return true;
+}
+
+CPareto_Archive::CPareto_Archive(const size_t problem_size, const size_t metrics_count, const std::wstring& log_path)
+	: mProblem_Size(problem_size), mMetrics_Count(metrics_count), mLog_Requested(!log_path.empty()) {
+
+	if (log_path.empty())
+		return;
+
+	mLog_File.open(filesystem::path{ log_path }, std::ios::binary | std::ios::trunc);
+	if (!mLog_File) {
+		std::wcerr << L"Cannot create the evaluation log " << log_path << std::endl;
+		return;
+	}
+
+	TEvaluation_Log_Header header;
+	header.problem_size = mProblem_Size;
+	header.metrics_count = mMetrics_Count;
+	mLog_File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+bool CPareto_Archive::is_open() const {
+	return !mLog_Requested || (mLog_File.is_open() && mLog_File.good());
+}
+
+void CPareto_Archive::Insert_2D(const double* parameters, const std::vector<double>& metrics) {
+	//the closest member with the first metric not greater decides whether the candidate is dominated
+	auto successor = mFront_2D.upper_bound(metrics[0]);
+	if ((successor != mFront_2D.begin()) && (std::prev(successor)->second.metrics[1] <= metrics[1]))
+		return;
+
+	//the candidate dominates the following members, until the second metric drops below its own
+	auto dominated = mFront_2D.lower_bound(metrics[0]);
+	while ((dominated != mFront_2D.end()) && (dominated->second.metrics[1] >= metrics[1]))
+		dominated = mFront_2D.erase(dominated);
+
+	mFront_2D.emplace_hint(dominated, metrics[0], TEvaluation{ std::vector<double>{ parameters, parameters + mProblem_Size }, metrics });
+	mFront_Size = mFront_2D.size();
+}
+
+void CPareto_Archive::Insert_ND(const double* parameters, const std::vector<double>& metrics) {
+	if (std::any_of(mFront.begin(), mFront.end(), [&](const TEvaluation& member) { return Dominates_Or_Equals(member.metrics, metrics); }))
+		return;
+
+	mFront.erase(std::remove_if(mFront.begin(), mFront.end(), [&](const TEvaluation& member) { return Dominates_Or_Equals(metrics, member.metrics); }), mFront.end());
+	mFront.push_back(TEvaluation{ std::vector<double>{ parameters, parameters + mProblem_Size }, metrics });
+	mFront_Size = mFront.size();
+}
+
+void CPareto_Archive::Record(const size_t count, const double* solutions, const std::vector<std::vector<double>>& metrics) {
+	std::lock_guard<std::mutex> lock{ mGuard };
+
+	for (size_t i = 0; i < count; i++) {
+		const auto& solution_metrics = metrics[i];
+		if (solution_metrics.size() != mMetrics_Count)
+			continue;
+
+		const double* parameters = solutions + i * mProblem_Size;
+		if (mLog_File.is_open()) {
+			mLog_File.write(reinterpret_cast<const char*>(parameters), mProblem_Size * sizeof(double));
+			mLog_File.write(reinterpret_cast<const char*>(solution_metrics.data()), mMetrics_Count * sizeof(double));
+			mLogged_Count++;
+		}
+
+		if (!std::all_of(solution_metrics.begin(), solution_metrics.end(), [](const double value) { return std::isfinite(value); }))
+			continue;
+
+		if (mMetrics_Count == 2)
+			Insert_2D(parameters, solution_metrics);
+		else
+			Insert_ND(parameters, solution_metrics);
+	}
+
+	if (mLog_File.is_open())
+		mLog_File.flush();	//a cancelled run keeps everything evaluated so far
+}
+
+size_t CPareto_Archive::logged_count() const {
+	std::lock_guard<std::mutex> lock{ mGuard };
+	return mLogged_Count;
+}
+
+bool CPareto_Archive::Write_Front(const std::wstring& path) const {
+	std::vector<const TEvaluation*> front;
+	std::lock_guard<std::mutex> lock{ mGuard };
+	for (const auto& [first_metric, member] : mFront_2D)
+		front.push_back(&member);
+	for (const auto& member : mFront)
+		front.push_back(&member);
+
+	//sorted by the metrics, so that the trade-offs read in order
+	std::sort(front.begin(), front.end(), [](const TEvaluation* a, const TEvaluation* b) { return a->metrics < b->metrics; });
+
+	std::wofstream front_file{ filesystem::path{ path }, std::ios::trunc };
+	if (!front_file) {
+		std::wcerr << L"Cannot create the Pareto front file " << path << std::endl;
+		return false;
+	}
+
+	front_file << std::setprecision(std::numeric_limits<double>::max_digits10);
+	for (size_t i = 0; i < mMetrics_Count; i++)
+		front_file << L"metric_" << i << L'\t';
+	for (size_t i = 0; i < mProblem_Size; i++)
+		front_file << L"parameter_" << i << (i + 1 < mProblem_Size ? L"\t" : L"");
+	front_file << std::endl;
+
+	for (const auto member : front) {
+		for (const double value : member->metrics)
+			front_file << value << L'\t';
+		for (size_t i = 0; i < mProblem_Size; i++)
+			front_file << member->parameters[i] << (i + 1 < mProblem_Size ? L"\t" : L"");
+		front_file << std::endl;
+	}
+
+	if (!front_file) {
+		std::wcerr << L"Cannot write the Pareto front file " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,82 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// keeps every evaluated solution of a multi-objective optimization; all of them go to an optional append-only log,
+// while only the non-dominated ones, with all the metrics minimized, stay in memory as the Pareto front
+class CPareto_Archive {
+protected:
+	struct TEvaluation {
+		std::vector<double> parameters, metrics;
+	};
+
+	const size_t mProblem_Size, mMetrics_Count;
+	const bool mLog_Requested;
+
+	mutable std::mutex mGuard;
+	std::ofstream mLog_File;
+	size_t mLogged_Count = 0;
+
+	//two objectives keep the front ordered by the first metric, along which the second one strictly decreases,
+	//so that an insertion costs a logarithmic lookup; any other count compares to the whole front
+	std::map<double, TEvaluation> mFront_2D;
+	std::vector<TEvaluation> mFront;
+	std::atomic<size_t> mFront_Size{ 0 };
+
+	void Insert_2D(const double* parameters, const std::vector<double>& metrics);
+	void Insert_ND(const double* parameters, const std::vector<double>& metrics);
+public:
+	CPareto_Archive(const size_t problem_size, const size_t metrics_count, const std::wstring& log_path);
+
+	bool is_open() const;	//the log, if requested, could be created
+
+	//metrics of failed evaluations are empty, and are neither logged nor part of the front
+	void Record(const size_t count, const double* solutions, const std::vector<std::vector<double>>& metrics);
+
+	bool Write_Front(const std::wstring& path) const;
+
+	size_t logged_count() const;
+	size_t front_size() const { return mFront_Size; }
+};
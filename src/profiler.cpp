@@ -0,0 +1,318 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "profiler.h"
+#include "execute.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+#include <scgms/utils/string_utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+std::atomic<size_t> Next_Profiler_Instance_Id{ 1 };
+
+constexpr std::chrono::milliseconds Cancel_Poll_Period{ 100 };
+
+thread_local int64_t Downstream_ns = 0;	//spent in the probes, which the current probe has called on this thread
+
+size_t Latency_Bucket(const int64_t latency_ns) {
+	if (latency_ns <= 1)
+		return 0;
+
+	const size_t bucket = static_cast<size_t>(std::log2(static_cast<double>(latency_ns)) * 4.0);
+	return std::min(bucket, Latency_Histogram_Size - 1);
+}
+
+void CFilter_Probe::Count_Emitted() {
+	mEmitted++;
+}
+
+HRESULT IfaceCalling CFilter_Probe::Execute(scgms::IDevice_Event* event) {
+	if (mUpstream)
+		mUpstream->Count_Emitted();
+
+	//the events, which the filter holds when another one arrives, e.g.; buffered until a later event
+	const int64_t queue = mEntered++ - mEmitted;
+	int64_t max_queue = mMax_Queue;
+	while ((queue > max_queue) && !mMax_Queue.compare_exchange_weak(max_queue, queue));
+
+	const int64_t outer_downstream_ns = Downstream_ns;
+	Downstream_ns = 0;
+
+	const int64_t start_ns = mProfiler.Elapsed_ns();
+	const HRESULT rc = mFilter->Execute(event);
+	const int64_t elapsed_ns = mProfiler.Elapsed_ns() - start_ns;
+
+	const int64_t own_ns = std::max(elapsed_ns - Downstream_ns, static_cast<int64_t>(0));
+	Downstream_ns = outer_downstream_ns + elapsed_ns;
+
+	auto& stats = mProfiler.Current_Thread_Stats()[mIndex];
+	stats.count++;
+	stats.latency_sum_ns += static_cast<double>(own_ns);
+	stats.latency_histogram[Latency_Bucket(own_ns)]++;
+
+	const size_t window = static_cast<size_t>(start_ns / std::chrono::duration_cast<std::chrono::nanoseconds>(Trace_Window).count());
+	if (stats.window_counts.size() <= window)
+		stats.window_counts.resize(window + 1, 0);
+	stats.window_counts[window]++;
+
+	return rc;
+}
+
+HRESULT IfaceCalling CChain_Profiler::CShut_Down_Sink::Execute(scgms::IDevice_Event* event) {
+	mUpstream->Count_Emitted();
+
+	//the event may be gone, once passed on
+	scgms::TDevice_Event* raw_event = nullptr;
+	const bool shut_down = Succeeded(event->Raw(&raw_event)) && (raw_event->event_code == scgms::NDevice_Event_Code::Shut_Down);
+
+	HRESULT rc = S_OK;
+	if (mOutput)
+		rc = mOutput->Execute(event);
+	else
+		scgms::UDevice_Event discarded_event{ event };	//releases the event
+
+	if (shut_down) {
+		{
+			std::lock_guard<std::mutex> lock{ mGuard };
+			mShut_Down = true;
+		}
+		mSignal.notify_all();
+	}
+
+	return rc;
+}
+
+bool CChain_Profiler::CShut_Down_Sink::Wait_For_Shut_Down(const std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock{ mGuard };
+	return mSignal.wait_for(lock, timeout, [this]() { return mShut_Down; });
+}
+
+void CChain_Profiler::TFilter_Stats::Merge(const TFilter_Stats& other) {
+	count += other.count;
+	latency_sum_ns += other.latency_sum_ns;
+	for (size_t i = 0; i < Latency_Histogram_Size; i++)
+		latency_histogram[i] += other.latency_histogram[i];
+
+	if (window_counts.size() < other.window_counts.size())
+		window_counts.resize(other.window_counts.size(), 0);
+	for (size_t i = 0; i < other.window_counts.size(); i++)
+		window_counts[i] += other.window_counts[i];
+}
+
+double CChain_Profiler::TFilter_Stats::Latency_Percentile(const double percentile) const {
+	const double threshold = percentile * 0.01 * static_cast<double>(count);
+	size_t cumulative = 0;
+	for (size_t i = 0; i < Latency_Histogram_Size; i++) {
+		cumulative += latency_histogram[i];
+		if ((cumulative > 0) && (static_cast<double>(cumulative) >= threshold))
+			return std::exp2(static_cast<double>(i + 1) * 0.25);	//upper bound of the bucket
+	}
+
+	return 0.0;
+}
+
+CChain_Profiler::CChain_Profiler() : mInstance_Id(Next_Profiler_Instance_Id++) {
+}
+
+CChain_Profiler::TThread_Stats& CChain_Profiler::Current_Thread_Stats() {
+	thread_local size_t cached_instance_id = 0;
+	thread_local TThread_Stats* cached_stats = nullptr;
+
+	if (cached_instance_id != mInstance_Id) {
+		std::lock_guard<std::mutex> lock{ mThreads_Guard };
+		mThreads.emplace_back(mProbes.size());
+		cached_stats = &mThreads.back();
+		cached_instance_id = mInstance_Id;
+	}
+
+	return *cached_stats;
+}
+
+int64_t CChain_Profiler::Elapsed_ns() const {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart_Time).count();
+}
+
+HRESULT CChain_Profiler::Run(scgms::SPersistent_Filter_Chain_Configuration& configuration, solver::TSolver_Progress& progress, scgms::IFilter* output) {
+	scgms::IFilter_Configuration_Link **link_begin = nullptr, **link_end = nullptr;
+	if ((configuration->get(&link_begin, &link_end) != S_OK) || (link_begin == link_end)) {
+		std::wcerr << L"Could not execute the filters!" << std::endl;
+		return E_FAIL;
+	}
+
+	const size_t filter_count = static_cast<size_t>(link_end - link_begin);
+	for (size_t i = 0; i < filter_count; i++)
+		mProbes.push_back(std::make_unique<CFilter_Probe>(*this, i, i > 0 ? mProbes[i - 1].get() : nullptr));
+	mFilter_Names.resize(filter_count);
+	CShut_Down_Sink sink{ output, mProbes.back().get() };
+
+	//like the executor, create and configure the filters from the last one, so that each filter has its output ready before it may emit
+	std::vector<scgms::IFilter*> filters(filter_count, nullptr);
+	refcnt::Swstr_list errors;
+	HRESULT rc = S_OK;
+	size_t first_configured = filter_count;
+	mStart_Time = std::chrono::steady_clock::now();
+	for (size_t i = filter_count; (i-- > 0) && Succeeded(rc); ) {
+		GUID filter_id = Invalid_GUID;
+		rc = link_begin[i]->Get_Filter_Id(&filter_id);
+		if (!Succeeded(rc))
+			break;
+
+		scgms::TFilter_Descriptor descriptor = scgms::Null_Filter_Descriptor;
+		mFilter_Names[i] = scgms::get_filter_descriptor_by_id(filter_id, descriptor) && descriptor.description ? descriptor.description : GUID_To_WString(filter_id);
+
+		scgms::IFilter* next = i + 1 < filter_count ? static_cast<scgms::IFilter*>(mProbes[i + 1].get()) : static_cast<scgms::IFilter*>(&sink);
+		rc = scgms::create_filter_body(&filter_id, next, &filters[i]);
+		if (Succeeded(rc) && !filters[i])
+			rc = E_FAIL;
+		if (!Succeeded(rc)) {
+			std::wcerr << L"Cannot create the filter " << mFilter_Names[i] << std::endl;
+			break;
+		}
+
+		mProbes[i]->Set_Filter(filters[i]);
+		rc = On_Filter_Created(filters[i], nullptr);
+		if (Succeeded(rc))
+			rc = filters[i]->Configure(link_begin[i], errors.get());
+		if (Succeeded(rc))
+			first_configured = i;
+	}
+
+	errors.for_each([](auto str) { std::wcerr << str << std::endl;	});
+
+	//the chain shuts down on its own, once its input runs out of the events, or on request
+	if (first_configured < filter_count) {
+		bool shut_down_requested = false;
+		do {
+			if (!shut_down_requested && (!Succeeded(rc) || (progress.cancelled != FALSE))) {
+				scgms::UDevice_Event shut_down_event{ scgms::NDevice_Event_Code::Shut_Down };
+				mProbes[first_configured]->Execute(shut_down_event.release());
+				shut_down_requested = true;
+			}
+		} while (!sink.Wait_For_Shut_Down(Cancel_Poll_Period));
+	}
+
+	//the filters stop their threads as they get released
+	for (scgms::IFilter* filter : filters)
+		if (filter)
+			filter->Release();
+
+	mRun_Time = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart_Time).count();
+
+	if (!Succeeded(rc)) {
+		std::wcerr << L"Could not execute the filters!" << std::endl;
+		return E_FAIL;
+	}
+
+	return progress.cancelled == FALSE ? S_OK : E_ABORT;
+}
+
+CChain_Profiler::TThread_Stats CChain_Profiler::Merged_Stats() {
+	TThread_Stats merged(mProbes.size());
+
+	std::lock_guard<std::mutex> lock{ mThreads_Guard };
+	for (const auto& thread_stats : mThreads)
+		for (size_t i = 0; i < merged.size(); i++)
+			merged[i].Merge(thread_stats[i]);
+
+	return merged;
+}
+
+void CChain_Profiler::Report() {
+	const auto merged = Merged_Stats();
+
+	std::wcout << std::endl << L"Profile of the filters in the chain order, the latency of a filter does not include the filters after it:" << std::endl;
+	std::wcout << L"filter\tevents\tevents/s\tmean latency [us]\tp99 latency [us]\tmax queue" << std::endl;
+	for (size_t i = 0; i < merged.size(); i++) {
+		const TFilter_Stats& stats = merged[i];
+		std::wcout << i << L' ' << mFilter_Names[i] << L'\t' << stats.count << L'\t'
+			<< (mRun_Time > 0.0 ? static_cast<double>(stats.count) / mRun_Time : 0.0) << L'\t'
+			<< (stats.count > 0 ? stats.latency_sum_ns / static_cast<double>(stats.count) * 1e-3 : 0.0) << L'\t'
+			<< stats.Latency_Percentile(99.0) * 1e-3 << L'\t'
+			<< mProbes[i]->max_queue() << std::endl;
+	}
+}
+
+bool CChain_Profiler::Write_Trace(const std::wstring& path) {
+	std::ofstream trace_file{ filesystem::path{ path }, std::ios::trunc };
+	if (!trace_file) {
+		std::wcerr << L"Cannot open the trace file " << path << std::endl;
+		return false;
+	}
+
+	const auto merged = Merged_Stats();
+	const int64_t run_time_us = static_cast<int64_t>(mRun_Time * 1e6);
+	const int64_t window_us = std::chrono::duration_cast<std::chrono::microseconds>(Trace_Window).count();
+
+	//filter descriptions are plain text, but must not break the JSON strings
+	std::vector<std::string> filter_names;
+	for (size_t i = 0; i < mFilter_Names.size(); i++) {
+		std::string name = std::to_string(i) + ' ' + Narrow_WString(mFilter_Names[i]);
+		std::replace_if(name.begin(), name.end(), [](const char c) { return (c == '"') || (c == '\\') || (static_cast<unsigned char>(c) < 0x20); }, '_');
+		filter_names.push_back(name);
+	}
+
+	trace_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+	trace_file << "{\"name\":\"chain execution\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":0,\"dur\":" << run_time_us << "}";
+
+	size_t window_count = 0;
+	for (const auto& stats : merged)
+		window_count = std::max(window_count, stats.window_counts.size());
+
+	//throughput of each filter as a counter track
+	const double windows_per_second = 1e6 / static_cast<double>(window_us);
+	for (size_t window = 0; window < window_count; window++) {
+		trace_file << "," << std::endl << "{\"name\":\"events/s\",\"ph\":\"C\",\"pid\":1,\"ts\":" << static_cast<int64_t>(window) * window_us << ",\"args\":{";
+		for (size_t i = 0; i < merged.size(); i++) {
+			const uint32_t count = window < merged[i].window_counts.size() ? merged[i].window_counts[window] : 0;
+			trace_file << (i == 0 ? "" : ",") << "\"" << filter_names[i] << "\":" << static_cast<double>(count) * windows_per_second;
+		}
+		trace_file << "}}";
+	}
+
+	trace_file << std::endl << "]}" << std::endl;
+
+	if (!trace_file) {
+		std::wcerr << L"Cannot write the trace file " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,137 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/FilterLib.h>
+#include <scgms/rtl/SolverLib.h>
+#include <scgms/rtl/referencedImpl.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+constexpr size_t Latency_Histogram_Size = 256;					//quarter-octave buckets of nanoseconds, i.e.; up to 2^64 ns
+constexpr std::chrono::milliseconds Trace_Window{ 100 };		//resolution of the throughput counters in the trace
+
+class CChain_Profiler;
+
+// sits in front of a single filter, and times its Execute; the time spent in the filters downstream, when they run
+// on the same thread, is not counted, so that each filter gets just its own latency
+class CFilter_Probe : public virtual scgms::IFilter, public virtual refcnt::CNotReferenced {
+protected:
+	CChain_Profiler& mProfiler;
+	const size_t mIndex;
+	scgms::IFilter* mFilter = nullptr;
+	CFilter_Probe* mUpstream = nullptr;			//whose emitted events this probe receives
+
+	std::atomic<int64_t> mEntered{ 0 }, mEmitted{ 0 };
+	std::atomic<int64_t> mMax_Queue{ 0 };		//events the filter has received, but not passed on yet
+public:
+	CFilter_Probe(CChain_Profiler& profiler, const size_t index, CFilter_Probe* upstream) : mProfiler(profiler), mIndex(index), mUpstream(upstream) {}
+
+	void Set_Filter(scgms::IFilter* filter) { mFilter = filter; }
+	void Count_Emitted();	//by whatever receives the events the filter emits
+	int64_t max_queue() const { return mMax_Queue; }
+
+	virtual HRESULT IfaceCalling Configure(scgms::IFilter_Configuration* configuration, refcnt::wstr_list* error_description) override final { return S_OK; }
+	virtual HRESULT IfaceCalling Execute(scgms::IDevice_Event* event) override final;
+};
+
+// builds the chain like the executor does, but with a probe in front of each filter, and reports the events/s,
+// the mean and p99 latency and the queue depth of each filter
+class CChain_Profiler {
+protected:
+	// terminal filter, which passes the events on to the optional output, and notices the shut down
+	class CShut_Down_Sink : public virtual scgms::IFilter, public virtual refcnt::CNotReferenced {
+	protected:
+		scgms::IFilter* mOutput;
+		CFilter_Probe* mUpstream;
+		std::mutex mGuard;
+		std::condition_variable mSignal;
+		bool mShut_Down = false;
+	public:
+		CShut_Down_Sink(scgms::IFilter* output, CFilter_Probe* upstream) : mOutput(output), mUpstream(upstream) {}
+
+		virtual HRESULT IfaceCalling Configure(scgms::IFilter_Configuration* configuration, refcnt::wstr_list* error_description) override final { return S_OK; }
+		virtual HRESULT IfaceCalling Execute(scgms::IDevice_Event* event) override final;
+
+		bool Wait_For_Shut_Down(const std::chrono::milliseconds timeout);
+	};
+
+	struct TFilter_Stats {
+		size_t count = 0;
+		double latency_sum_ns = 0.0;
+		std::array<size_t, Latency_Histogram_Size> latency_histogram{};
+		std::vector<uint32_t> window_counts;					//events per trace window
+
+		void Merge(const TFilter_Stats& other);
+		double Latency_Percentile(const double percentile) const;	//ns, approximated by the histogram bucket
+	};
+
+	using TThread_Stats = std::vector<TFilter_Stats>;			//per filter, in the chain order
+
+	const size_t mInstance_Id;
+	std::chrono::steady_clock::time_point mStart_Time = std::chrono::steady_clock::now();
+	double mRun_Time = 0.0;										//s
+
+	std::vector<std::wstring> mFilter_Names;
+	std::vector<std::unique_ptr<CFilter_Probe>> mProbes;
+
+	//each thread, which executes the chain, records into its own stats, so that the threads never contend
+	std::mutex mThreads_Guard;
+	std::list<TThread_Stats> mThreads;
+
+	TThread_Stats Merged_Stats();
+public:
+	CChain_Profiler();
+
+	TThread_Stats& Current_Thread_Stats();
+	int64_t Elapsed_ns() const;
+
+	//runs the chain until its input shuts it down, or the progress gets cancelled; the events leaving the chain go to the optional output
+	HRESULT Run(scgms::SPersistent_Filter_Chain_Configuration& configuration, solver::TSolver_Progress& progress, scgms::IFilter* output);
+
+	void Report();	//once the execution has finished
+	bool Write_Trace(const std::wstring& path);	//Chrome trace-event JSON
+};
@@ -0,0 +1,364 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "server.h"
+
+#include "execute.h"
+#include "optimize.h"
+#include "sweep.h"
+#include "batch.h"
+#include "utils.h"
+#include "cancellation.h"
+
+#include <scgms/utils/string_utils.h>
+
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#ifdef _WIN32
+
+int Serve(const TAction& action, solver::TSolver_Progress& progress) {
+	std::wcerr << L"Serving jobs requires Unix domain sockets, which are not supported on this platform!" << std::endl;
+	return __LINE__;
+}
+
+#else
+
+#include <csignal>
+#include <cerrno>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+
+constexpr size_t Max_Request_Length = 64 * 1024;
+constexpr int Accept_Poll_Timeout = 200;	//ms, how often the server checks whether it has been cancelled
+constexpr time_t Request_Timeout = 10;		//s, so that a silent client cannot block the shutdown
+
+bool Receive_Line(const int socket, std::string& line) {
+	char buffer[4096];
+
+	line.clear();
+	size_t line_end = std::string::npos;
+	while ((line_end == std::string::npos) && (line.size() < Max_Request_Length)) {
+		const auto received = recv(socket, buffer, sizeof(buffer), 0);
+		if (received <= 0)
+			break;
+
+		line.append(buffer, static_cast<size_t>(received));
+		line_end = line.find('\n');
+	}
+
+	if (line_end != std::string::npos)
+		line.resize(line_end);
+	else if (line.size() >= Max_Request_Length)
+		return false;
+
+	if (!line.empty() && (line.back() == '\r'))
+		line.pop_back();
+
+	return !line.empty();
+}
+
+bool Send_Line(const int socket, const std::string& line) {
+	const std::string message = line + '\n';
+
+	size_t sent_total = 0;
+	while (sent_total < message.size()) {
+		const auto sent = send(socket, message.data() + sent_total, message.size() - sent_total, 0);
+		if (sent <= 0)
+			return false;	//the client has gone away, but the job still runs to its end
+
+		sent_total += static_cast<size_t>(sent);
+	}
+
+	return true;
+}
+
+class CJob_Server {
+protected:
+	struct TConnection {
+		std::thread thread;
+		std::atomic<bool> finished{ false };
+	};
+
+	const TAction& mAction;
+	solver::TSolver_Progress& mServer_Progress;
+	const size_t mWorker_Count;
+
+	std::mutex mJobs_Guard;
+	std::condition_variable mWorker_Released;
+	size_t mRunning_Count = 0;
+	size_t mLast_Job_Id = 0;
+	std::map<size_t, solver::TSolver_Progress*> mJobs;	//both waiting and running jobs
+
+	std::list<TConnection> mConnections;				//accessed by the accepting thread only
+
+	int Run_Job(const TAction& job_action, solver::TSolver_Progress& progress);
+	void Submit(const int socket, const std::vector<std::wstring>& tokens);
+	void Cancel(const int socket, const std::vector<std::wstring>& tokens);
+	void Handle_Connection(const int socket);
+	void Reap_Connections(const bool wait_for_all);
+	void Cancel_All_Jobs();
+public:
+	CJob_Server(const TAction& action, solver::TSolver_Progress& progress) :
+		mAction(action), mServer_Progress(progress), mWorker_Count(Resolve_Worker_Count(action.worker_count)) {}
+
+	int Serve();
+};
+
+int CJob_Server::Run_Job(const TAction& job_action, solver::TSolver_Progress& progress) {
+	auto [rc, configuration] = Load_Experimental_Setup(job_action.config_path, job_action.variables);
+	if (!Succeeded(rc))
+		return __LINE__;
+
+	switch (job_action.action) {
+		case NAction::execute:
+		{
+			CRun_Budget budget{ progress, job_action.timeout };
+			return Execute_Configuration(configuration, job_action.save_config, progress);
+		}
+
+		case NAction::optimize:
+			return Optimize_Configuration(configuration, job_action, progress);
+
+		case NAction::sweep:
+			return Sweep_Configuration(configuration, job_action, progress);
+
+		default:
+			return __LINE__;
+	}
+}
+
+void CJob_Server::Submit(const int socket, const std::vector<std::wstring>& tokens) {
+	//the request is a regular command line, just without the executable name
+	std::vector<std::string> arguments{ "scgms-console" };
+	for (size_t i = 1; i < tokens.size(); i++)
+		arguments.push_back(Narrow_WString(tokens[i]));
+
+	std::vector<const char*> argv;
+	for (const auto& argument : arguments)
+		argv.push_back(argument.c_str());
+
+	const TAction job_action = Parse_Options(static_cast<int>(argv.size()), argv.data());
+	if ((job_action.action != NAction::execute) && (job_action.action != NAction::optimize) && (job_action.action != NAction::sweep)) {
+		Send_Line(socket, "rejected");
+		return;
+	}
+
+	solver::TSolver_Progress job_progress = solver::Null_Solver_Progress;
+	size_t job_id = 0;
+	{
+		std::lock_guard<std::mutex> lock{ mJobs_Guard };
+		job_id = ++mLast_Job_Id;
+		mJobs.emplace(job_id, &job_progress);
+	}
+
+	Send_Line(socket, "accepted " + std::to_string(job_id));
+
+	//wait for a free worker, unless cancelled in the meantime
+	bool started = false;
+	{
+		std::unique_lock<std::mutex> lock{ mJobs_Guard };
+		mWorker_Released.wait(lock, [&]() { return (mRunning_Count < mWorker_Count) || (job_progress.cancelled != FALSE); });
+		if (job_progress.cancelled == FALSE) {
+			mRunning_Count++;
+			started = true;
+		}
+	}
+
+	const int exit_code = started ? Run_Job(job_action, job_progress) : __LINE__;
+
+	{
+		std::lock_guard<std::mutex> lock{ mJobs_Guard };
+		if (started)
+			mRunning_Count--;
+		mJobs.erase(job_id);
+	}
+	mWorker_Released.notify_all();
+
+	std::wcout << L"Job " << job_id << L" (" << job_action.config_path << L") finished with exit code " << exit_code << L'.' << std::endl;
+	Send_Line(socket, "finished " + std::to_string(job_id) + ' ' + std::to_string(exit_code));
+}
+
+void CJob_Server::Cancel(const int socket, const std::vector<std::wstring>& tokens) {
+	bool ok = tokens.size() == 2;
+	const size_t job_id = ok ? str_2_uint(Narrow_WString(tokens[1]).c_str(), ok) : 0;
+
+	bool found = false;
+	if (ok) {
+		std::lock_guard<std::mutex> lock{ mJobs_Guard };
+		auto job = mJobs.find(job_id);
+		if (job != mJobs.end()) {
+			Cancel_Execution(*job->second);
+			found = true;
+		}
+	}
+	mWorker_Released.notify_all();	//a waiting job leaves the queue at once
+
+	Send_Line(socket, (found ? "cancelled " : "unknown ") + (ok ? std::to_string(job_id) : std::string{}));
+}
+
+void CJob_Server::Handle_Connection(const int socket) {
+	std::string request;
+	if (!Receive_Line(socket, request)) {
+		Send_Line(socket, "rejected");
+		return;
+	}
+
+	const auto tokens = Split_Manifest_Line(Widen_Char(request.c_str()));
+	if (!tokens.empty() && (tokens[0] == L"submit"))
+		Submit(socket, tokens);
+	else if (!tokens.empty() && (tokens[0] == L"cancel"))
+		Cancel(socket, tokens);
+	else
+		Send_Line(socket, "rejected");
+}
+
+void CJob_Server::Reap_Connections(const bool wait_for_all) {
+	for (auto iter = mConnections.begin(); iter != mConnections.end(); ) {
+		if (wait_for_all || iter->finished) {
+			iter->thread.join();
+			iter = mConnections.erase(iter);
+		}
+		else
+			iter++;
+	}
+}
+
+void CJob_Server::Cancel_All_Jobs() {
+	{
+		std::lock_guard<std::mutex> lock{ mJobs_Guard };
+		for (auto& [job_id, job_progress] : mJobs)
+			Cancel_Execution(*job_progress);
+	}
+	mWorker_Released.notify_all();
+}
+
+int CJob_Server::Serve() {
+	const std::string socket_path = Narrow_WString(mAction.config_path);
+
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (socket_path.size() >= sizeof(address.sun_path)) {
+		std::wcerr << L"The socket path " << mAction.config_path << L" is too long!" << std::endl;
+		return __LINE__;
+	}
+	std::copy(socket_path.begin(), socket_path.end(), address.sun_path);
+
+	//a socket left over by a crashed server would make the bind fail, but nothing else is removed;
+	//a socket, which still accepts connections, belongs to a live server, and must be kept
+	struct stat existing_file;
+	if ((stat(socket_path.c_str(), &existing_file) == 0) && S_ISSOCK(existing_file.st_mode)) {
+		const int probe_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (probe_socket < 0) {
+			std::wcerr << L"Cannot create the server socket!" << std::endl;
+			return __LINE__;
+		}
+
+		const bool stale = (connect(probe_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) && (errno == ECONNREFUSED);
+		close(probe_socket);
+		if (!stale) {
+			std::wcerr << L"Another server is already serving on the socket " << mAction.config_path << std::endl;
+			return __LINE__;
+		}
+
+		unlink(socket_path.c_str());
+	}
+
+	const int listening_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listening_socket < 0) {
+		std::wcerr << L"Cannot create the server socket!" << std::endl;
+		return __LINE__;
+	}
+
+	if ((bind(listening_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) || (listen(listening_socket, SOMAXCONN) != 0)) {
+		std::wcerr << L"Cannot listen on the socket " << mAction.config_path << std::endl;
+		close(listening_socket);
+		return __LINE__;
+	}
+
+	signal(SIGPIPE, SIG_IGN);	//a client, which has gone away, must not terminate the server
+
+	std::wcout << L"Serving jobs on " << mAction.config_path << L" using up to " << mWorker_Count << L" workers." << std::endl;
+
+	while (mServer_Progress.cancelled == FALSE) {
+		pollfd listening_poll{ listening_socket, POLLIN, 0 };
+		const int ready = poll(&listening_poll, 1, Accept_Poll_Timeout);
+
+		Reap_Connections(false);
+
+		if ((ready <= 0) || ((listening_poll.revents & POLLIN) == 0))
+			continue;	//timeout, or interrupted by a signal
+
+		const int client_socket = accept(listening_socket, nullptr, nullptr);
+		if (client_socket < 0)
+			continue;
+
+		const timeval request_timeout{ Request_Timeout, 0 };
+		setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &request_timeout, sizeof(request_timeout));
+
+		TConnection& connection = mConnections.emplace_back();
+		connection.thread = std::thread{ [this, client_socket, &connection]() {
+			Handle_Connection(client_socket);
+			close(client_socket);
+			connection.finished = true;
+		} };
+	}
+
+	std::wcout << L"Shutting down the server..." << std::endl;
+
+	close(listening_socket);
+	Cancel_All_Jobs();
+	Reap_Connections(true);
+	unlink(socket_path.c_str());
+
+	return 0;
+}
+
+int Serve(const TAction& action, solver::TSolver_Progress& progress) {
+	CJob_Server server{ action, progress };
+	return server.Serve();
+}
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread;
+// the producer owns the tail, the consumer owns the head, and each only reads the other one
+template <typename T>
+class CSPSC_Ring {
+protected:
+	std::vector<T> mSlots;
+	const size_t mMask;
+
+	alignas(64) std::atomic<size_t> mHead{ 0 };		//next slot to pop
+	alignas(64) std::atomic<size_t> mTail{ 0 };		//next slot to push
+
+	static size_t Round_Up_To_Power_Of_Two(const size_t capacity) {
+		size_t result = 1;
+		while (result < capacity)
+			result <<= 1;
+		return result;
+	}
+public:
+	CSPSC_Ring(const size_t capacity) : mSlots(Round_Up_To_Power_Of_Two(capacity)), mMask(mSlots.size() - 1) {}
+
+	bool Try_Push(const T& value) {
+		const size_t tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mHead.load(std::memory_order_acquire) == mSlots.size())
+			return false;	//full
+
+		mSlots[tail & mMask] = value;
+		mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Try_Pop(T& value) {
+		const size_t head = mHead.load(std::memory_order_relaxed);
+		if (head == mTail.load(std::memory_order_acquire))
+			return false;	//empty
+
+		value = mSlots[head & mMask];
+		mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const { return mSlots.size(); }
+};
@@ -0,0 +1,73 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "startup_timing.h"
+#include "utils.h"
+
+#include <array>
+#include <atomic>
+#include <iostream>
+
+//ns plus one, so that zero means not recorded yet
+std::array<std::atomic<int64_t>, static_cast<size_t>(NStartup_Phase::count)> Startup_Phase_Durations = {};
+
+void Record_Startup_Phase(const NStartup_Phase phase, const std::chrono::steady_clock::duration duration) {
+	int64_t not_recorded = 0;
+	Startup_Phase_Durations[static_cast<size_t>(phase)].compare_exchange_strong(not_recorded, std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() + 1);
+}
+
+void Report_Startup_Timing() {
+	const std::array<const wchar_t*, static_cast<size_t>(NStartup_Phase::count)> phase_names = {
+		L"library load", L"Qt init", L"option parse", L"config parse", L"executor construction"
+	};
+
+	std::wcout << std::endl << L"Startup timing [ms]:" << std::endl;
+	double total = 0.0;
+	for (size_t i = 0; i < phase_names.size(); i++) {
+		const int64_t duration = Startup_Phase_Durations[i] - 1;
+		std::wcout << phase_names[i] << L'\t';
+		if (duration >= 0) {
+			total += static_cast<double>(duration) * 1e-6;
+			std::wcout << static_cast<double>(duration) * 1e-6 << std::endl;
+		}
+		else
+			std::wcout << L"n/a" << std::endl;
+	}
+	std::wcout << L"total\t" << total << std::endl;
+
+	//resident memory tells the cost of the loaded libraries, and of Qt, alongside their time
+	std::wcout << L"Peak memory usage: " << static_cast<double>(Peak_Memory_Usage()) / (1024.0 * 1024.0) << L" MiB" << std::endl;
+}
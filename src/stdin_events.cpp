@@ -0,0 +1,249 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "stdin_events.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+	#include <Windows.h>
+	#include <io.h>
+	#include <fcntl.h>
+#else
+	#include <poll.h>
+	#include <unistd.h>
+	#include <cerrno>
+#endif
+
+//spins briefly, then sleeps, so that an idle side costs no CPU, while a busy one reacts at once
+void Backoff(size_t& idle_rounds) {
+	if (idle_rounds++ < 64)
+		std::this_thread::yield();
+	else
+		std::this_thread::sleep_for(std::chrono::microseconds{ 50 });
+}
+
+CStdin_Event_Feeder::~CStdin_Event_Feeder() {
+	Finish();
+}
+
+void CStdin_Event_Feeder::Start(scgms::SFilter_Executor executor) {
+	mExecutor = executor;
+
+#ifdef _WIN32
+	_setmode(_fileno(stdin), _O_BINARY);	//the binary format must not go through the newline translation
+#endif
+
+	mReader = std::thread{ &CStdin_Event_Feeder::Reader, this };
+	mInjector = std::thread{ &CStdin_Event_Feeder::Injector, this };
+}
+
+void CStdin_Event_Feeder::Finish() {
+	mStop = true;
+
+#ifdef _WIN32
+	//the reader may be blocked in reading a pipe, which has no timeout
+	if (mReader.joinable())
+		CancelSynchronousIo(mReader.native_handle());
+#endif
+
+	if (mReader.joinable())
+		mReader.join();
+	if (mInjector.joinable())
+		mInjector.join();
+
+	mExecutor.reset();
+}
+
+bool CStdin_Event_Feeder::Read_Block(char* buffer, const size_t size, size_t& read_size) {
+#ifdef _WIN32
+	const int read_result = _read(_fileno(stdin), buffer, static_cast<unsigned int>(size));
+	if ((read_result <= 0) || mStop)
+		return false;
+
+	read_size = static_cast<size_t>(read_result);
+	return true;
+#else
+	//polls, so that the reader notices the stop even with a silent producer
+	pollfd stdin_poll{ STDIN_FILENO, POLLIN, 0 };
+	while (!mStop) {
+		const int ready = poll(&stdin_poll, 1, 100);
+		if (ready < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		if (ready == 0)
+			continue;
+
+		const ssize_t read_result = read(STDIN_FILENO, buffer, size);
+		if (read_result < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			return false;
+		}
+
+		read_size = static_cast<size_t>(read_result);
+		return read_result > 0;
+	}
+
+	return false;
+#endif
+}
+
+bool CStdin_Event_Feeder::Push(const TEvent_Record& record) {
+	size_t idle_rounds = 0;
+	while (!mQueue.Try_Push(record)) {
+		if (mStop)
+			return false;
+		Backoff(idle_rounds);
+	}
+
+	return true;
+}
+
+void CStdin_Event_Feeder::Reader() {
+	enum class NFormat { unknown, lines, binary };
+	NFormat format = NFormat::unknown;
+
+	CEvent_Line_Parser line_parser;
+	size_t line_number = 0;
+
+	std::vector<char> data;		//read, but not yet parsed bytes
+	size_t parsed_size = 0;
+	std::vector<char> block(Stdin_Read_Block_Size);
+
+	bool end_of_input = false;
+	while (!end_of_input && !mStop) {
+		size_t read_size = 0;
+		end_of_input = !Read_Block(block.data(), block.size(), read_size);
+		data.insert(data.end(), block.begin(), block.begin() + read_size);
+
+		if (format == NFormat::unknown) {
+			if ((data.size() < sizeof(TEvent_Stream_Header)) && !end_of_input)
+				continue;
+
+			//the binary format announces itself with its header, anything else must be lines
+			format = NFormat::lines;
+			TEvent_Stream_Header header;
+			if (data.size() >= sizeof(header)) {
+				memcpy(&header, data.data(), sizeof(header));
+				if (Is_Event_Stream_Header(header)) {
+					format = NFormat::binary;
+					parsed_size = sizeof(header);
+				}
+			}
+		}
+
+		bool pushed = true;
+		if (format == NFormat::binary) {
+			TEvent_Record record;
+			while (pushed && (data.size() - parsed_size >= sizeof(record))) {
+				memcpy(&record, data.data() + parsed_size, sizeof(record));
+				parsed_size += sizeof(record);
+
+				if (Is_Streamable_Event_Code(record.event_code))
+					pushed = Push(record);
+				else
+					mMalformed_Count++;
+			}
+
+			if (end_of_input && (data.size() > parsed_size))
+				std::wcerr << L"The event stream ends with a truncated record!" << std::endl;
+		}
+		else {
+			while (pushed && (parsed_size < data.size())) {
+				const char* line_begin = data.data() + parsed_size;
+				const char* data_end = data.data() + data.size();
+				const char* line_end = static_cast<const char*>(memchr(line_begin, '\n', data_end - line_begin));
+				if (!line_end) {
+					if (!end_of_input)
+						break;	//wait for the rest of the line
+					line_end = data_end;
+				}
+
+				line_number++;
+				TEvent_Record record;
+				bool is_event = false;
+				if (!line_parser.Parse(line_begin, line_end, record, is_event)) {
+					if (mMalformed_Count++ == 0)
+						std::wcerr << L"Skipping a malformed event on line " << line_number << L" of the standard input." << std::endl;
+				}
+				else if (is_event)
+					pushed = Push(record);
+
+				parsed_size = std::min(static_cast<size_t>(line_end - data.data()) + 1, data.size());
+			}
+		}
+
+		if (!pushed)
+			break;
+
+		data.erase(data.begin(), data.begin() + parsed_size);
+		parsed_size = 0;
+	}
+
+	mReader_Done.store(true, std::memory_order_release);
+}
+
+void CStdin_Event_Feeder::Injector() {
+	TEvent_Record record;
+	size_t idle_rounds = 0;
+
+	while (!mStop) {
+		//once the reader is done, an empty queue stays empty
+		const bool reader_done = mReader_Done.load(std::memory_order_acquire);
+		if (mQueue.Try_Pop(record)) {
+			idle_rounds = 0;
+			if (!Succeeded(mExecutor.Execute(Make_Device_Event(record))))
+				return;	//the chain has shut down on its own, or was cancelled
+
+			mInjected_Count++;
+			continue;
+		}
+
+		if (reader_done) {
+			//the end of the stream shuts the chain down, like the end of an input file does
+			mExecutor.Execute(scgms::UDevice_Event{ scgms::NDevice_Event_Code::Shut_Down });
+			return;
+		}
+
+		Backoff(idle_rounds);
+	}
+}
@@ -0,0 +1,78 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include "execute.h"
+#include "event_stream.h"
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+constexpr size_t Stdin_Event_Queue_Capacity = 1 << 16;	//events parsed ahead of the chain, bounds the memory
+constexpr size_t Stdin_Read_Block_Size = 1 << 20;
+
+// feeds the executor with the events read from the standard input, in either of the event stream formats;
+// the reader thread parses ahead, while the injector thread runs the chain, and a full queue stops the reading,
+// so that a faster producer on the other end of the pipe blocks instead of growing the memory
+class CStdin_Event_Feeder : public CEvent_Feeder {
+protected:
+	CSPSC_Ring<TEvent_Record> mQueue{ Stdin_Event_Queue_Capacity };
+	scgms::SFilter_Executor mExecutor;
+
+	std::atomic<bool> mStop{ false };
+	std::atomic<bool> mReader_Done{ false };
+	std::atomic<size_t> mInjected_Count{ 0 }, mMalformed_Count{ 0 };
+
+	std::thread mReader, mInjector;
+
+	bool Read_Block(char* buffer, const size_t size, size_t& read_size);	//false on the end of the input, or once stopped
+	bool Push(const TEvent_Record& record);									//waits for a free slot, false once stopped
+
+	void Reader();
+	void Injector();
+public:
+	virtual ~CStdin_Event_Feeder();
+
+	virtual void Start(scgms::SFilter_Executor executor) override final;
+	virtual void Finish() override final;
+
+	size_t injected_count() const { return mInjected_Count; }
+	size_t malformed_count() const { return mMalformed_Count; }
+};
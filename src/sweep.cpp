@@ -0,0 +1,222 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "sweep.h"
+
+#include "execute.h"
+#include "event_log.h"
+#include "utils.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+
+struct TSweep_Axis {
+	size_t parameter_index = 0;	//into TAction::parameters_to_optimize
+	size_t value_index = 0;		//into the concatenated values of all the parameters, as Read_Parameters returns them
+	TSweep_Range range;
+};
+
+struct TSweep_Point {
+	HRESULT rc = E_FAIL;
+	std::vector<double> values, metrics;
+};
+
+double Axis_Value(const TSweep_Range& range, const size_t step) {
+	if (range.steps < 2)
+		return range.lower;
+
+	return range.lower + (range.upper - range.lower) * static_cast<double>(step) / static_cast<double>(range.steps - 1);
+}
+
+HRESULT Write_Sweep_Point(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TOptimize_Parameter>& parameters, const std::vector<TSweep_Axis>& axes, const std::vector<double>& base_values, const std::vector<double>& values) {
+	//the elements, which no axis sweeps, keep their configured values
+	std::vector<double> point_values = base_values;
+	for (size_t axis_idx = 0; axis_idx < axes.size(); axis_idx++)
+		point_values[axes[axis_idx].value_index] = values[axis_idx];
+
+	return Write_Parameters(configuration, parameters, point_values);
+}
+
+int Sweep_Configuration(scgms::SPersistent_Filter_Chain_Configuration configuration, const TAction& action, solver::TSolver_Progress& progress) {
+
+	//1. resolve the grid axes against the loaded configuration
+	std::vector<TSweep_Axis> axes;
+	size_t point_count = 1;
+	size_t value_offset = 0;
+
+	for (size_t param_idx = 0; param_idx < action.parameters_to_optimize.size(); param_idx++) {
+		const auto& param = action.parameters_to_optimize[param_idx];
+
+		scgms::SFilter_Configuration_Link link = configuration[param.index];
+		std::vector<double> lbound, params, ubound;
+		if (!link || !link.Read_Parameters(param.name.c_str(), lbound, params, ubound)) {
+			std::wcerr << L"Cannot read parameters " << param.name << L" of the filter no. " << param.index << L".\n";
+			return __LINE__;
+		}
+
+		for (const auto& range : param.sweep_ranges) {
+			if (range.element >= params.size()) {
+				std::wcerr << L"Parameters " << param.name << L" have no element no. " << range.element << L".\n";
+				return __LINE__;
+			}
+
+			if (point_count > std::numeric_limits<size_t>::max() / range.steps) {
+				std::wcerr << L"The sweep grid is too large!\n";
+				return __LINE__;
+			}
+
+			point_count *= range.steps;
+			axes.push_back({ param_idx, value_offset + range.element, range });
+		}
+
+		value_offset += params.size();
+	}
+
+	const auto [base_rc, base_lbound, base_values, base_ubound] = Read_Parameters(configuration, action.parameters_to_optimize);
+	if ((base_rc != S_OK) || (base_values.size() != value_offset)) {
+		std::wcerr << L"Cannot read the parameters to sweep!\n";
+		return __LINE__;
+	}
+
+	//2. keep the configuration in memory, so that we can clone it for every grid point
+	const auto [image_ok, image] = Load_Configuration_Image(action.config_path);
+	if (!image_ok)
+		return __LINE__;
+
+	//all the points replay the same mapped event log in place of the chain's first filter
+	std::shared_ptr<const CEvent_Log> event_log;
+	if (!action.event_log_path.empty()) {
+		event_log = Acquire_Event_Log(action.event_log_path);
+		if (!event_log)
+			return __LINE__;
+	}
+
+	const size_t worker_count = std::min(point_count, Resolve_Worker_Count(action.worker_count));
+	std::wcout << L"Sweeping " << point_count << L" grid points using " << worker_count << L" workers..." << std::endl;
+
+	//3. evaluate all the points
+	std::vector<TSweep_Point> points(point_count);
+	std::atomic<size_t> evaluated_count{ 0 };
+	std::mutex report_guard;
+
+	Parallel_For(point_count, worker_count, [&](const size_t point_idx) {
+		if (progress.cancelled != FALSE)
+			return;
+
+		TSweep_Point& point = points[point_idx];
+
+		//decode the point index as a mixed-radix number, the last axis changes the fastest
+		point.values.resize(axes.size());
+		size_t remainder = point_idx;
+		for (size_t axis_idx = axes.size(); axis_idx-- > 0; ) {
+			const auto& range = axes[axis_idx].range;
+			point.values[axis_idx] = Axis_Value(range, remainder % range.steps);
+			remainder /= range.steps;
+		}
+
+		auto [rc, point_configuration] = Instantiate_Configuration(image, action.variables);
+		if (Succeeded(rc))
+			rc = Write_Sweep_Point(point_configuration, action.parameters_to_optimize, axes, base_values, point.values);
+
+		if (Succeeded(rc)) {
+			std::unique_ptr<CEvent_Log_Feeder> input;
+			if (event_log)
+				input = std::make_unique<CEvent_Log_Feeder>(event_log);
+			std::tie(rc, point.metrics) = Evaluate_Configuration(point_configuration, progress, input.get());
+		}
+
+		point.rc = rc;
+
+		const size_t done = ++evaluated_count;
+		std::lock_guard<std::mutex> lock{ report_guard };
+		std::wcout << L" " << done << L'/' << point_count;
+		std::wcout.flush();
+	});
+
+	std::wcout << std::endl;
+
+	//4. write the result table
+	std::wofstream output_file;
+	if (!action.sweep_output.empty()) {
+		output_file.open(filesystem::path{ action.sweep_output });
+		if (!output_file) {
+			std::wcerr << L"Cannot open the sweep output file " << action.sweep_output << std::endl;
+			return __LINE__;
+		}
+	}
+
+	std::wostream& output = action.sweep_output.empty() ? std::wcout : output_file;
+
+	size_t metric_count = 0;
+	for (const auto& point : points)
+		metric_count = std::max(metric_count, point.metrics.size());
+
+	output << L"point";
+	for (const auto& axis : axes)
+		output << L'\t' << action.parameters_to_optimize[axis.parameter_index].index << L':'
+			<< action.parameters_to_optimize[axis.parameter_index].name << L'[' << axis.range.element << L']';
+	for (size_t i = 0; i < metric_count; i++)
+		output << L"\tmetric_" << i;
+	output << std::endl;
+
+	size_t failed_count = 0;
+	output << std::setprecision(std::numeric_limits<double>::max_digits10);
+	for (size_t point_idx = 0; point_idx < points.size(); point_idx++) {
+		const auto& point = points[point_idx];
+		if (!Succeeded(point.rc)) {
+			failed_count++;
+			continue;
+		}
+
+		output << point_idx;
+		for (const double value : point.values)
+			output << L'\t' << value;
+		for (size_t i = 0; i < metric_count; i++)
+			output << L'\t' << (i < point.metrics.size() ? point.metrics[i] : std::numeric_limits<double>::quiet_NaN());
+		output << L'\n';
+	}
+	output.flush();
+
+	if (failed_count > 0) {
+		std::wcerr << failed_count << L" of " << point_count << L" grid points could not be evaluated." << std::endl;
+		return __LINE__;
+	}
+
+	return 0;
+}
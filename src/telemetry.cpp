@@ -0,0 +1,149 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "telemetry.h"
+
+#include "utils.h"
+
+#include <scgms/rtl/FilesystemLib.h>
+
+#include <iomanip>
+#include <iostream>
+
+CTelemetry::CTelemetry(const std::wstring& path, const std::chrono::milliseconds interval, const solver::TSolver_Progress& progress, const std::atomic<size_t>& evaluations)
+	: mInterval(interval), mProgress(progress), mEvaluations(evaluations), mStart_CPU_Time(Process_CPU_Time()) {
+
+	const filesystem::path telemetry_path{ path };
+	mCSV = telemetry_path.extension().wstring() == L".csv";
+
+	mFile.open(telemetry_path, std::ios::trunc);
+	if (!mFile) {
+		std::wcerr << L"Cannot open the telemetry file " << path << std::endl;
+		return;
+	}
+
+	mFile << std::setprecision(std::numeric_limits<double>::max_digits10);
+	if (mCSV) {
+		mFile << "timestamp_ms,event,wall_s,cpu_s,progress,max_progress,evaluations,evaluations_per_s";
+		for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++)
+			mFile << ",best_metric_" << i;
+		mFile << std::endl;
+	}
+
+	Record("start");
+
+	mSampler = std::thread{ [this]() {
+		std::unique_lock<std::mutex> lock{ mStop_Guard };
+		while (!mStop_Signal.wait_for(lock, mInterval, [this]() { return mStop; }))
+			Record("sample");
+	} };
+}
+
+CTelemetry::~CTelemetry() {
+	{
+		std::lock_guard<std::mutex> lock{ mStop_Guard };
+		mStop = true;
+	}
+	mStop_Signal.notify_all();
+
+	if (mSampler.joinable())
+		mSampler.join();
+
+	if (mFile.is_open())
+		Record("finish");
+}
+
+void CTelemetry::Record(const char* event) {
+	if (!mFile.is_open())
+		return;
+
+	const auto now = std::chrono::steady_clock::now();
+	const auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	const double wall_time = std::chrono::duration<double>(now - mStart_Time).count();
+	const double cpu_time = Process_CPU_Time() - mStart_CPU_Time;
+
+	const size_t evaluations = mEvaluations;
+	const double elapsed = std::chrono::duration<double>(now - mRecent_Time).count();
+	const double evaluations_per_second = elapsed > 0.0 ? static_cast<double>(evaluations - mRecent_Evaluations) / elapsed : 0.0;
+	mRecent_Time = now;
+	mRecent_Evaluations = evaluations;
+
+	const char* separator = mCSV ? "," : ",\"";
+	const char* assignment = mCSV ? "" : "\":";
+	auto field = [&](const char* name) -> std::ofstream& {
+		if (!mCSV)
+			mFile << separator << name << assignment;
+		else
+			mFile << separator;
+		return mFile;
+	};
+
+	if (mCSV)
+		mFile << timestamp << ',' << event;
+	else
+		mFile << "{\"timestamp_ms\":" << timestamp << ",\"event\":\"" << event << '"';
+
+	field("wall_s") << wall_time;
+	field("cpu_s") << cpu_time;
+	field("progress") << mProgress.current_progress;
+	field("max_progress") << mProgress.max_progress;
+	field("evaluations") << evaluations;
+	field("evaluations_per_s") << evaluations_per_second;
+
+	if (mCSV) {
+		for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
+			const double metric = mProgress.best_metric[i];
+			mFile << ',';
+			if (std::isfinite(metric))
+				mFile << metric;
+		}
+		mFile << '\n';
+	}
+	else {
+		mFile << ",\"best_metric\":[";
+		for (size_t i = 0; i < solver::Maximum_Objectives_Count; i++) {
+			const double metric = mProgress.best_metric[i];
+			mFile << (i > 0 ? "," : "");
+			if (std::isfinite(metric))
+				mFile << metric;
+			else
+				mFile << "null";	//JSON has no NaN
+		}
+		mFile << "]}\n";
+	}
+
+	mFile.flush();
+}
@@ -0,0 +1,75 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <scgms/rtl/SolverLib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// periodically samples the progress into a file; .csv files get CSV, anything else gets JSON lines
+class CTelemetry {
+protected:
+	std::ofstream mFile;
+	bool mCSV = false;
+	const std::chrono::milliseconds mInterval;
+	const solver::TSolver_Progress& mProgress;
+	const std::atomic<size_t>& mEvaluations;
+
+	const std::chrono::steady_clock::time_point mStart_Time = std::chrono::steady_clock::now();
+	const double mStart_CPU_Time;
+	std::chrono::steady_clock::time_point mRecent_Time = mStart_Time;
+	size_t mRecent_Evaluations = 0;
+
+	std::mutex mStop_Guard;
+	std::condition_variable mStop_Signal;
+	bool mStop = false;
+	std::thread mSampler;
+
+	void Record(const char* event);
+public:
+	CTelemetry(const std::wstring& path, const std::chrono::milliseconds interval, const solver::TSolver_Progress& progress, const std::atomic<size_t>& evaluations);
+	~CTelemetry();	//writes the final record
+
+	bool is_open() const { return mFile.is_open(); }
+};
@@ -35,149 +35,146 @@
  */
 
 #include "utils.h"
+#include "worker_pool.h"
 
 #include <fstream>
+#include <atomic>
+#include <ctime>
+
+#ifdef _WIN32
+	#include <Windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
 
 #include <scgms/utils/string_utils.h>
 
-void Load_Hints(const std::wstring &hint_path, const size_t expected_parameters_size, const bool parameters_file_type, std::vector<std::vector<double>> &hints_container) {	
-	std::wifstream hints_file{ filesystem::path{ hint_path } };
-	if (hints_file) {
-		std::wstring line;
-
-		const size_t initial_hint_count = hints_container.size();
-
-		size_t line_counter = 0;
-		while (std::getline(hints_file, line)) {
-			line_counter++;
-
-			bool ok = false;
-			if (!line.empty()) {
-				auto loaded_hint = str_2_dbls(line.c_str(), ok);
-
-				if (parameters_file_type) {
-					//loaded parameters also contain lower and upper bounds, which we need to strip off
-					ok = loaded_hint.size() == 3 * expected_parameters_size;
-					if (ok) {
-						loaded_hint.erase(loaded_hint.begin(), loaded_hint.begin() + expected_parameters_size);	//remove lower bounds
-						loaded_hint.resize(expected_parameters_size);	//trim off upper bounds
-					}
-				} 
-				else
-					ok = (loaded_hint.size() == expected_parameters_size);
-
-				if (ok)
-					hints_container.push_back(loaded_hint);
-				else
-					std::wcerr << L"Line no. " << line_counter << " contains a hint with a different than expected size.\n";
-			}
-
-			if (!ok)
-				std::wcerr << L"Skipped a possibly corrupted parameters line!" << std::endl;
+void Set_Variables(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TVariable>& variables, std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration>& result) {
+	HRESULT rc = std::get<0>(result);
+
+	//let us set the variables
+	for (const auto& var : variables) {
+		rc = configuration->Set_Variable(var.name.c_str(), var.value.c_str());
+		if (!Succeeded(rc)) {
+			std::wcerr << L"Failed to set variable named " << var.name << ", to a value of " << var.value << std::endl;
+
+			std::get<0>(result) = rc;
 		}
+	}
 
-		std::wcout << L"Loaded " << hints_container.size() - initial_hint_count << " additional hints from " << hint_path << std::endl;
+	std::get<1>(result) = std::move(configuration);
 
-	} else
-		std::wcerr << L"Cannot open the hints file!" << std::endl;
+	if (rc == S_FALSE)
+		std::wcerr << L"Warning: some filters were not loaded, or some variables were not set!" << std::endl;
 }
 
+std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> Load_Experimental_Setup(int argc, char** argv, const std::vector<TVariable> &variables) {
+	//Let's try to load the configuration file
+	const std::wstring config_filepath = argc > 1 ? std::wstring{ argv[1], argv[1] + strlen(argv[1]) } : std::wstring{};
+	return Load_Experimental_Setup(config_filepath, variables);
+}
 
-bool Load_Hints(const std::vector<std::wstring>& hint_paths, const size_t expected_parameters_size, const bool parameters_file_type, std::vector<std::vector<double>>& hints_container) {
-
-	const auto current_dir = filesystem::current_path();
+std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> Load_Experimental_Setup(const std::wstring& config_filepath, const std::vector<TVariable>& variables) {
+	std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> result;
 
-	for (const auto& path_mask : hint_paths) {
+	scgms::SPersistent_Filter_Chain_Configuration configuration;
 
-		const filesystem::path full_path{ Make_Absolute_Path(path_mask, current_dir) };
+	refcnt::Swstr_list errors;
 
-		//First, we need to ensure that we are not dealing with a uniquely identified file name
-		if (Is_Regular_File_Or_Symlink(path_mask))
-			Load_Hints(path_mask, expected_parameters_size, parameters_file_type, hints_container);
-		else {
-			//if not, then we are asked to enumerate entire directory, may be with a mask
+	HRESULT rc = E_FAIL;		//asssume the worst
+	if (configuration) {		//and check whether we have constructed the main config container
+		rc = configuration->Load_From_File(config_filepath.c_str(), errors.get());	//and load it if we did
+	}
 
-			const auto effective_path = full_path.parent_path();	//note that path_mask may have already contained a different, than current directory!
+	errors.for_each([](auto str) { std::wcerr << str << std::endl;	});
 
-			if (Is_Directory(effective_path)) {
+	std::get<0>(result) = rc;
 
-				const std::wstring wildcard = path_mask;
-				constexpr bool case_sensitive =
-#ifdef  _WIN32
-					false
-#else
-					true
-#endif   
-					;
-
-				std::error_code ec;
-				if (effective_path.empty() || (!filesystem::exists(effective_path, ec) || ec))
-					return false;
-
-				for (auto& enumerated_path : filesystem::directory_iterator(effective_path)) {
-					const bool matches_wildcard = Match_Wildcard(enumerated_path.path().filename().wstring(), path_mask, case_sensitive);
-
-					if (matches_wildcard) {
-						if (Is_Regular_File_Or_Symlink(enumerated_path))
-							Load_Hints(enumerated_path.path().wstring(), expected_parameters_size, parameters_file_type, hints_container);
-					}
-				}
-			}
-		}
-	}
+	if (Succeeded(rc))
+		Set_Variables(configuration, variables, result);
+	else
+		std::wcerr << L"Cannot load the configuration file " << config_filepath << std::endl << L"Error code: " << rc << std::endl;
 
-	return true;
+	return result;
 }
 
+std::tuple<bool, TConfiguration_Image> Load_Configuration_Image(const std::wstring& config_filepath) {
+	std::tuple<bool, TConfiguration_Image> result{ false, {} };
 
+	std::ifstream config_file{ filesystem::path{ config_filepath }, std::ios::binary };
+	if (!config_file) {
+		std::wcerr << L"Cannot open the configuration file " << config_filepath << std::endl;
+		return result;
+	}
 
-std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> Load_Experimental_Setup(int argc, char** argv, const std::vector<TVariable> &variables) {
+	auto& image = std::get<1>(result);
+	image.file_path = Make_Absolute_Path(config_filepath, filesystem::current_path()).wstring();
+	image.content.assign(std::istreambuf_iterator<char>{ config_file }, std::istreambuf_iterator<char>{});
+
+	std::get<0>(result) = !config_file.bad();
+	return result;
+}
+
+std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> Instantiate_Configuration(const TConfiguration_Image& image, const std::vector<TVariable>& variables) {
 	std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> result;
 
-	//Let's try to load the configuration file
-	const std::wstring config_filepath = argc > 1 ? std::wstring{ argv[1], argv[1] + strlen(argv[1]) } : std::wstring{};
 	scgms::SPersistent_Filter_Chain_Configuration configuration;
-
 	refcnt::Swstr_list errors;
 
-	HRESULT rc = E_FAIL;		//asssume the worst
-	if (configuration) {		//and check whether we have constructed the main config container
-		rc = configuration->Load_From_File(config_filepath.c_str(), errors.get());	//and load it if we did
+	HRESULT rc = E_FAIL;
+	if (configuration) {
+		//relative paths in the configuration are relative to the original file
+		rc = configuration->Set_Parent_Path(filesystem::path{ image.file_path }.parent_path().wstring().c_str());
+		if (Succeeded(rc))
+			rc = configuration->Load_From_Memory(image.content.data(), image.content.size(), errors.get());
 	}
 
 	errors.for_each([](auto str) { std::wcerr << str << std::endl;	});
 
 	std::get<0>(result) = rc;
 
-	if (Succeeded(rc)) {
-
-		//let us set the variables
-		if (!variables.empty()) {
-			for (const auto& var : variables) {
-				rc = configuration->Set_Variable(var.name.c_str(), var.value.c_str());
-				if (!Succeeded(rc)) {
-					std::wcerr << L"Failed to set variable named " << var.name << ", to a value of " << var.value << std::endl;
+	if (Succeeded(rc))
+		Set_Variables(configuration, variables, result);
+	else
+		std::wcerr << L"Cannot instantiate the configuration " << image.file_path << std::endl << L"Error code: " << rc << std::endl;
 
-					std::get<0>(result) = rc;
-				}
-			}
-		}
+	return result;
+}
 
-		std::get<1>(result) = std::move(configuration);
+HRESULT Save_Configuration(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::wstring& config_filepath) {
+	//the temporary file shares the directory, so that the relative paths stay valid and the rename cannot cross file systems
+	const filesystem::path final_path{ config_filepath };
+	filesystem::path temporary_path{ final_path };
+	temporary_path += L".tmp";
 
-		if (rc == S_FALSE)
-			std::wcerr << L"Warning: some filters were not loaded, or some variables were not set!" << std::endl;
-	} else
-		std::wcerr << L"Cannot load the configuration file " << config_filepath << std::endl << L"Error code: " << rc << std::endl;
+	refcnt::Swstr_list errors;
+	const HRESULT rc = configuration->Save_To_File(temporary_path.wstring().c_str(), errors.get());
+	errors.for_each([](auto str) { std::wcerr << str << std::endl; });
+	if (!Succeeded(rc))
+		return rc;
+
+	//rename replaces the previous configuration at once, so a crash cannot leave a partial file behind
+	std::error_code ec;
+	filesystem::rename(temporary_path, final_path, ec);
+	if (ec) {
+		std::wcerr << L"Cannot replace the configuration " << config_filepath << std::endl;
+		return E_FAIL;
+	}
 
-	return result;
+	return rc;
 }
 
 
 
 std::tuple<HRESULT, size_t> Count_Parameters_Size(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TOptimize_Parameter>& parameters) {
+	const auto [rc, lbound, params, ubound] = Read_Parameters(configuration, parameters);
+	return { rc, params.size() };
+}
 
-	size_t count = 0;
+std::tuple<HRESULT, std::vector<double>, std::vector<double>, std::vector<double>> Read_Parameters(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TOptimize_Parameter>& parameters) {
+
+	std::vector<double> lower_bounds, all_params, upper_bounds;
 
 	for (size_t i = 0; i < parameters.size(); i++) {
 
@@ -185,17 +182,94 @@ std::tuple<HRESULT, size_t> Count_Parameters_Size(scgms::SPersistent_Filter_Chai
 
 		if (!configuration_link_parameters) {
 			std::wcout << L"Cannot get configuration link (no. " << i <<") with parameters to optimize.\n";
-			return { E_INVALIDARG, 0 };
+			return { E_INVALIDARG, {}, {}, {} };
 		}
 
 		std::vector<double> lbound, params, ubound;
 		if (!configuration_link_parameters.Read_Parameters(parameters[i].name.c_str(), lbound, params, ubound)) {
 			std::wcout << L"Cannot read parameters configuration link no. " << i << ", with parameters " << parameters[i].name << ".\n";
-			return { E_FAIL, 0 };
+			return { E_FAIL, {}, {}, {} };
 		}
 
-		count += params.size();
+		lower_bounds.insert(lower_bounds.end(), lbound.begin(), lbound.end());
+		all_params.insert(all_params.end(), params.begin(), params.end());
+		upper_bounds.insert(upper_bounds.end(), ubound.begin(), ubound.end());
 	}
 
-	return { S_OK, count };
+	return { S_OK, lower_bounds, all_params, upper_bounds };
+}
+
+HRESULT Write_Parameters(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TOptimize_Parameter>& parameters, const std::vector<double>& values) {
+
+	size_t offset = 0;
+
+	for (size_t i = 0; i < parameters.size(); i++) {
+
+		scgms::SFilter_Configuration_Link configuration_link_parameters = configuration[parameters[i].index];
+		if (!configuration_link_parameters)
+			return E_INVALIDARG;
+
+		std::vector<double> lbound, params, ubound;
+		if (!configuration_link_parameters.Read_Parameters(parameters[i].name.c_str(), lbound, params, ubound))
+			return E_FAIL;
+
+		if (offset + params.size() > values.size())
+			return E_INVALIDARG;
+
+		std::copy(values.begin() + offset, values.begin() + offset + params.size(), params.begin());
+		offset += params.size();
+
+		if (!configuration_link_parameters.Write_Parameters(parameters[i].name.c_str(), lbound, params, ubound))
+			return E_FAIL;
+	}
+
+	return offset == values.size() ? S_OK : E_INVALIDARG;
+}
+
+
+size_t Resolve_Worker_Count(const size_t requested_count) {
+	if (requested_count > 0)
+		return requested_count;
+
+	const size_t hw_count = static_cast<size_t>(std::thread::hardware_concurrency());
+	return hw_count > 0 ? hw_count : 1;	//hardware_concurrency may return zero, if it cannot tell
+}
+
+void Parallel_For(const size_t count, const size_t worker_count, const std::function<void(const size_t index)>& body) {
+	Worker_Pool().Run(count, worker_count, body);
+}
+
+double Process_CPU_Time() {
+#ifdef _WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+		return 0.0;
+
+	auto to_seconds = [](const FILETIME& time) {
+		return static_cast<double>((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7;	//100ns units
+	};
+	return to_seconds(kernel_time) + to_seconds(user_time);
+#else
+	return static_cast<double>(std::clock()) / static_cast<double>(CLOCKS_PER_SEC);
+#endif
+}
+
+size_t Peak_Memory_Usage() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+
+	return static_cast<size_t>(counters.PeakWorkingSetSize);
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	#ifdef __APPLE__
+		return static_cast<size_t>(usage.ru_maxrss);			//bytes
+	#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;	//kilobytes
+	#endif
+#endif
 }
@@ -34,6 +34,8 @@
  *    Volume 177, pp. 354-362, 2020
  */
 
+#pragma once
+
 #include "options.h"
 
 #include <scgms/rtl/scgmsLib.h>
@@ -50,18 +52,30 @@
 #include <climits>
 #include <chrono>
 #include <cmath>
-
- /*
-  *	If you do not need database access, or do not want to use Qt, then
-  *  #define DDO_NOT_USE_QT
-  */
-#ifndef DDO_NOT_USE_QT
-	#include <scgms/rtl/qdb_connector.h>
-	#include <QtCore/QCoreApplication>
-#endif
+#include <functional>
 
 
 std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> Load_Experimental_Setup(int argc, char** argv, const std::vector<TVariable> &variables);
-bool Load_Hints(const std::vector<std::wstring>& hint_paths, const size_t parameters_file_type, const bool parameters_file, std::vector<std::vector<double>>& hints_container); //paths may include wildcard
+std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> Load_Experimental_Setup(const std::wstring& config_filepath, const std::vector<TVariable>& variables);
+
+//in-memory copy of a configuration file, so that it can be cloned without touching the disk
+struct TConfiguration_Image {
+	std::wstring file_path;
+	std::string content;
+};
+
+std::tuple<bool, TConfiguration_Image> Load_Configuration_Image(const std::wstring& config_filepath);
+std::tuple<HRESULT, scgms::SPersistent_Filter_Chain_Configuration> Instantiate_Configuration(const TConfiguration_Image& image, const std::vector<TVariable>& variables);
+HRESULT Save_Configuration(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::wstring& config_filepath);	//replaces the file atomically
 
 std::tuple<HRESULT, size_t> Count_Parameters_Size(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TOptimize_Parameter>& parameters);
+//concatenated lower bounds, parameters and upper bounds of all the parameters to optimize
+std::tuple<HRESULT, std::vector<double>, std::vector<double>, std::vector<double>> Read_Parameters(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TOptimize_Parameter>& parameters);
+//writes the concatenated parameters back, keeping the bounds
+HRESULT Write_Parameters(scgms::SPersistent_Filter_Chain_Configuration& configuration, const std::vector<TOptimize_Parameter>& parameters, const std::vector<double>& values);
+
+size_t Resolve_Worker_Count(const size_t requested_count);	//zero requests as many workers as there are CPU cores
+void Parallel_For(const size_t count, const size_t worker_count, const std::function<void(const size_t index)>& body);	//calls body for each index in [0, count) on up to worker_count threads, the calling one and those of the shared worker pool
+
+double Process_CPU_Time();	//seconds of CPU time consumed by all threads of this process
+size_t Peak_Memory_Usage();	//peak resident set size of this process, in bytes
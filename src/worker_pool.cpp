@@ -0,0 +1,149 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+#include "worker_pool.h"
+
+#include "utils.h"
+#include "affinity.h"
+
+#include <algorithm>
+#include <memory>
+
+thread_local CWorker_Scope* Current_Worker_Scope = nullptr;	//a pool thread, or a caller working on its loop, is placed already
+
+CWorker_Pool::~CWorker_Pool() {
+	{
+		std::lock_guard<std::mutex> lock{ mGuard };
+		mStop = true;
+	}
+	mLoop_Available.notify_all();
+
+	for (auto& thread : mThreads)
+		thread.join();
+}
+
+void CWorker_Pool::Configure(const size_t worker_count) {
+	std::lock_guard<std::mutex> lock{ mGuard };
+	if (!mStarted)
+		mWorker_Count = worker_count;
+}
+
+void CWorker_Pool::Work_On(TLoop& loop, CWorker_Scope& scope) {
+	for (size_t index = loop.next_index++; index < loop.count; index = loop.next_index++) {
+		(*loop.body)(index);
+		scope.Task_Done();
+	}
+}
+
+void CWorker_Pool::Worker() {
+	CWorker_Scope scope;	//placed for the whole life of the thread
+	Current_Worker_Scope = &scope;
+
+	std::unique_lock<std::mutex> lock{ mGuard };
+	while (true) {
+		mLoop_Available.wait(lock, [this]() { return mStop || !mLoops.empty(); });
+		if (mStop)
+			break;
+
+		TLoop& loop = *mLoops.front();
+		if (++loop.helpers >= loop.helper_limit)
+			mLoops.pop_front();	//the loop has as many workers as it asked for
+
+		lock.unlock();
+		Work_On(loop, scope);
+		scope.Flush();		//the thread lives until the process exits, so the utilization report would miss its work otherwise
+		lock.lock();
+
+		//no indices are left to join the loop for, and its caller waits for the last helper only
+		const auto queued = std::find(mLoops.begin(), mLoops.end(), &loop);
+		if (queued != mLoops.end())
+			mLoops.erase(queued);
+		if (--loop.helpers == 0)
+			mLoop_Done.notify_all();
+	}
+
+	Current_Worker_Scope = nullptr;
+}
+
+void CWorker_Pool::Run(const size_t count, const size_t worker_count, const std::function<void(const size_t index)>& body) {
+	if (count == 0)
+		return;
+
+	TLoop loop;
+	loop.count = count;
+	loop.body = &body;
+	loop.helper_limit = std::min(count, Resolve_Worker_Count(worker_count)) - 1;
+
+	if (loop.helper_limit > 0) {
+		std::lock_guard<std::mutex> lock{ mGuard };
+		if (!mStarted) {
+			mStarted = true;
+			for (size_t i = 1; i < Resolve_Worker_Count(mWorker_Count); i++)
+				mThreads.push_back(std::thread{ &CWorker_Pool::Worker, this });
+		}
+
+		if (!mThreads.empty()) {
+			mLoops.push_back(&loop);
+			mLoop_Available.notify_all();
+		}
+	}
+
+	//the calling thread is one of the workers; even a single one is placed and measured, so that the utilization report covers all the work
+	CWorker_Scope* const outer_scope = Current_Worker_Scope;
+	std::unique_ptr<CWorker_Scope> own_scope;
+	if (!outer_scope) {
+		own_scope = std::make_unique<CWorker_Scope>();
+		Current_Worker_Scope = own_scope.get();
+	}
+
+	Work_On(loop, *Current_Worker_Scope);
+
+	{
+		std::unique_lock<std::mutex> lock{ mGuard };
+		const auto queued = std::find(mLoops.begin(), mLoops.end(), &loop);
+		if (queued != mLoops.end())
+			mLoops.erase(queued);
+		mLoop_Done.wait(lock, [&loop]() { return loop.helpers == 0; });
+	}
+
+	Current_Worker_Scope = outer_scope;
+}
+
+CWorker_Pool& Worker_Pool() {
+	//constructed on the first use, i.e.; after the utilization records, so that it is destroyed before them
+	static CWorker_Pool pool;
+	return pool;
+}
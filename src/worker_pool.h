@@ -0,0 +1,80 @@
+/**
+ * SmartCGMS - continuous glucose monitoring and controlling framework
+ * https://diabetes.zcu.cz/
+ *
+ * Copyright (c) since 2018 University of West Bohemia.
+ *
+ * Contact:
+ * diabetes@mail.kiv.zcu.cz
+ * Medical Informatics, Department of Computer Science and Engineering
+ * Faculty of Applied Sciences, University of West Bohemia
+ * Univerzitni 8, 301 00 Pilsen
+ * Czech Republic
+ * 
+ * 
+ * Purpose of this software:
+ * This software is intended to demonstrate work of the diabetes.zcu.cz research
+ * group to other scientists, to complement our published papers. It is strictly
+ * prohibited to use this software for diagnosis or treatment of any medical condition,
+ * without obtaining all required approvals from respective regulatory bodies.
+ *
+ * Especially, a diabetic patient is warned that unauthorized use of this software
+ * may result into severe injure, including death.
+ *
+ *
+ * Licensing terms:
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under these license terms is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *
+ * a) This file is available under the Apache License, Version 2.0.
+ * b) When publishing any derivative work or results obtained using this software, you agree to cite the following paper:
+ *    Tomas Koutny and Martin Ubl, "SmartCGMS as a Testbed for a Blood-Glucose Level Prediction and/or 
+ *    Control Challenge with (an FDA-Accepted) Diabetic Patient Simulation", Procedia Computer Science,  
+ *    Volume 177, pp. 354-362, 2020
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CWorker_Scope;
+
+// threads, which outlive the individual Parallel_For calls, so that concurrent callers (e.g., the islands, or the batch jobs)
+// share them instead of each starting as many threads as there are CPU cores; a caller works on its own loop, too,
+// so that its loop completes even when all the pool threads are busy with other loops
+class CWorker_Pool {
+protected:
+	struct TLoop {
+		size_t count = 0;
+		const std::function<void(const size_t index)>* body = nullptr;
+		size_t helper_limit = 0;	//pool threads, which may join the caller
+		size_t helpers = 0;			//pool threads working on the loop, guarded by mGuard
+		std::atomic<size_t> next_index{ 0 };
+	};
+
+	std::mutex mGuard;
+	std::condition_variable mLoop_Available, mLoop_Done;
+	std::deque<TLoop*> mLoops;		//loops, which pool threads may still join
+	std::vector<std::thread> mThreads;
+	size_t mWorker_Count = 0;		//zero means as many workers as there are CPU cores
+	bool mStarted = false;			//the threads start with the first loop, which needs them
+	bool mStop = false;
+
+	void Worker();
+	static void Work_On(TLoop& loop, CWorker_Scope& scope);
+public:
+	~CWorker_Pool();
+
+	void Configure(const size_t worker_count);	//the caller is one of the workers, so the pool has one thread less; no effect, once started
+	void Run(const size_t count, const size_t worker_count, const std::function<void(const size_t index)>& body);
+};
+
+CWorker_Pool& Worker_Pool();	//the single pool of this process